@@ -4,6 +4,10 @@
  * Change Logs:
  * Date         Author        Notes
  * 2023-06-03   Nico Maas     first version
+ * 2026-10-17   Nico Maas     reassembly moved into the portable core library
+ * 2026-10-17   Nico Maas     optional TM Transfer Frame input
+ * 2026-10-17   Nico Maas     per-APID routing, msh command ccsds_route
+ * 2026-10-17   Nico Maas     configuration file loaded at runtime, msh command ccsds_config
  */
 
 #include <rtthread.h>
@@ -11,61 +15,159 @@
 #include <lwip/sockets.h>
 #include <lwip/netif.h>
 #include <lwip/netifapi.h>
+#include <lwip/tcpip.h>
 
-// define SERVER_IP_ADDR, SERVER_NETMASK and SERVER_GATEWAY_IP to manually set IP address
-// or leave commented out to activate DHCP Client
-//#define SERVER_IP_ADDR      "192.168.178.2"
-//#define SERVER_NETMASK      "255.255.255.0"
-//#define SERVER_GATEWAY_IP   "192.168.178.1"
-#define SERVER_UDP_PORT     4711
-#define DEST_IP_ADDR        "192.168.178.3"
-#define DEST_UDP_PORT       4712
+#include "ccsds_conf.h"
+#include "ccsds_config.h"
+#include "ccsds_forward.h"
+#include "ccsds_frame.h"
+#include "ccsds_fsm.h"
+#include "ccsds_metrics.h"
+#include "ccsds_queue.h"
+#include "ccsds_seq.h"
+#include "ccsds_trace.h"
 
-// CCSDS configuration
-#define PACKET_VERSION_NUMBER   0   // Default: 0
-#define PACKET_TYPE             0   // Telemetry Packet: 0
-// all allowed APID numbers [0-2047] including if the packet is going to have a 2nd header (1) or not (0)
-static const unsigned int APID_CONFIG[][2] = {{123, 1}, {815, 1}, {2047, 0}};
+// number of received datagrams buffered between lwIP and the state machine, must be a power of two
+#define INCOMING_RING_SIZE  32
 
-#define INCOMING_QUEUE_SIZE 128
-#define OUTGOING_QUEUE_SIZE 512
-
-// generated Syncwords
-unsigned short SYNCWORDS[(sizeof(APID_CONFIG)/(2*sizeof(unsigned int)))];
+// configuration (SYNCWORD lookup) of the state machine thread
+static struct ccsds_conf_reader conf_reader;
 
 static struct udp_pcb* udp_server_pcb;
-static rt_mq_t incoming_message_queue;
-static rt_mq_t outgoing_message_queue;
+
+// received datagrams (lwIP pbufs) on their way from udp_receive_callback to the state machine thread
+// the pbufs are handed over as they are, the state machine parses their payload in place and frees them afterwards
+static void* incoming_ring[INCOMING_RING_SIZE];
+static struct ccsds_queue incoming_queue;
+
+static struct ccsds_pool pool;
+#if FRAME_INPUT
+// frame input stage with one state machine per virtual channel of FRAME_VCIDS
+static struct ccsds_frame frame;
+static struct ccsds_fsm vc_fsm[CCSDS_FRAME_VCS];
+#else
+static struct ccsds_fsm fsm;
+#endif
+static struct ccsds_seq seq;
+static struct ccsds_forward forward;
+// routing table published last, only freed once ccsds_route publishes another one
+static struct ccsds_route_table* route_table;
+
+// counters of the lwIP thread (receiving) and the state machine thread (reassembly and forwarding)
+static struct ccsds_metrics rx_metrics;
+static struct ccsds_metrics fsm_metrics;
+static struct ccsds_metrics stats_total;
+static struct ccsds_metrics_publisher stats_publisher;
+
+// the reassembly, fed with frames or with the plain packet stream
+static void reassembly_feed(struct pbuf* p, uint64_t rx_time_us)
+{
+    // feed every pbuf of the chain as one span
+    #if FRAME_INPUT
+    frame.rx_time_us = rx_time_us;
+    for (struct pbuf* q = p; q != RT_NULL; q = q->next)
+    {
+        ccsds_frame_feed(&frame, (const rt_uint8_t*)q->payload, q->len);
+    }
+    ccsds_frame_end(&frame);
+    #else
+    fsm.rx_time_us = rx_time_us;
+    for (struct pbuf* q = p; q != RT_NULL; q = q->next)
+    {
+        ccsds_fsm_feed(&fsm, (const rt_uint8_t*)q->payload, q->len);
+    }
+    #endif
+}
+
+static int32_t reassembly_timeout(uint64_t now_us)
+{
+    #if FRAME_INPUT
+    return ccsds_frame_timeout(&frame, now_us);
+    #else
+    return ccsds_fsm_timeout(&fsm, now_us);
+    #endif
+}
+
+static void reassembly_poll(uint64_t now_us)
+{
+    #if FRAME_INPUT
+    ccsds_frame_poll(&frame, now_us);
+    #else
+    ccsds_fsm_poll(&fsm, now_us);
+    #endif
+}
+
+// a state machine still finishes a packet under the previous configuration
+static int reassembly_switching(void)
+{
+    #if FRAME_INPUT
+    for (int i = 0; i < CCSDS_FRAME_VCS; i++)
+    {
+        if ((FRAME_VCIDS & (1 << i)) && ccsds_fsm_switching(&vc_fsm[i]))
+        {
+            return 1;
+        }
+    }
+    return 0;
+    #else
+    return ccsds_fsm_switching(&fsm);
+    #endif
+}
+
+// take a configuration published by ccsds_config, partial packets finish under the one they started with
+// and the previous configuration is released once they are done
+static void reassembly_config(void)
+{
+    if (conf_reader.old != RT_NULL && !reassembly_switching())
+    {
+        ccsds_conf_reader_retire(&conf_reader);
+    }
+    struct ccsds_conf* conf = ccsds_conf_reader_update(&conf_reader);
+    if (conf == RT_NULL)
+    {
+        return;
+    }
+    // packets the state machines still complete under the previous configuration carry it to the sequence stage
+    ccsds_seq_set_apids(&seq, &conf->table);
+    #if FRAME_INPUT
+    for (int i = 0; i < CCSDS_FRAME_VCS; i++)
+    {
+        if (FRAME_VCIDS & (1 << i))
+        {
+            ccsds_fsm_set_apids(&vc_fsm[i], &conf->table);
+        }
+    }
+    #else
+    ccsds_fsm_set_apids(&fsm, &conf->table);
+    #endif
+}
 
 static void udp_receive_callback(void* arg, struct udp_pcb* pcb, struct pbuf* p, const ip_addr_t* addr, u16_t port)
 {
     // If new UDP packet is received
     if (p != NULL)
     {
-        // ... and its not empty
-        char* payload = rt_malloc(p->tot_len);
-        if (payload != NULL)
+        rx_metrics.datagrams++;
+        rx_metrics.rx_bytes += p->tot_len;
+        // pass the whole datagram to the state machine, ownership of the pbuf moves with it
+        if (ccsds_queue_push(&incoming_queue, p) != 0)
         {
-            rt_memcpy(payload, p->payload, p->tot_len);
-            // split the data to byte size
-            for (int i = 0; i < p->tot_len; i++)
-            {
-                rt_uint8_t bytePart = payload[i];
-                // add the bytes of the packet to the message queue
-                rt_mq_send(incoming_message_queue, &bytePart, sizeof(rt_uint8_t));
-            }
+            // ring is full, drop the complete datagram instead of random parts of it
+            rx_metrics.queue_drops++;
+            pbuf_free(p);
         }
-        pbuf_free(p);
-        free(payload);
     }
 }
 
 static void udp_server_thread(void* parameter)
 {
     // Create a UDP server on the current IP address of the network interface
+    // raw API outside the tcpip thread, under the core lock (LWIP_TCPIP_CORE_LOCKING, see osal_rtthread.c)
+    LOCK_TCPIP_CORE();
     udp_server_pcb = udp_new();
     udp_bind(udp_server_pcb, IP_ADDR_ANY, SERVER_UDP_PORT);
     udp_recv(udp_server_pcb, udp_receive_callback, NULL);
+    UNLOCK_TCPIP_CORE();
     rt_kprintf("UDP server started\n");
     while (1)
     {
@@ -73,291 +175,38 @@ static void udp_server_thread(void* parameter)
     }
 }
 
-// CRC16-CCITT-False Checksum
-unsigned short crc16sum(rt_uint8_t *data, unsigned int len, unsigned short crc)
-{
-    static const unsigned short table[256] = {
-    0x0000U,0x1021U,0x2042U,0x3063U,0x4084U,0x50A5U,0x60C6U,0x70E7U,
-    0x8108U,0x9129U,0xA14AU,0xB16BU,0xC18CU,0xD1ADU,0xE1CEU,0xF1EFU,
-    0x1231U,0x0210U,0x3273U,0x2252U,0x52B5U,0x4294U,0x72F7U,0x62D6U,
-    0x9339U,0x8318U,0xB37BU,0xA35AU,0xD3BDU,0xC39CU,0xF3FFU,0xE3DEU,
-    0x2462U,0x3443U,0x0420U,0x1401U,0x64E6U,0x74C7U,0x44A4U,0x5485U,
-    0xA56AU,0xB54BU,0x8528U,0x9509U,0xE5EEU,0xF5CFU,0xC5ACU,0xD58DU,
-    0x3653U,0x2672U,0x1611U,0x0630U,0x76D7U,0x66F6U,0x5695U,0x46B4U,
-    0xB75BU,0xA77AU,0x9719U,0x8738U,0xF7DFU,0xE7FEU,0xD79DU,0xC7BCU,
-    0x48C4U,0x58E5U,0x6886U,0x78A7U,0x0840U,0x1861U,0x2802U,0x3823U,
-    0xC9CCU,0xD9EDU,0xE98EU,0xF9AFU,0x8948U,0x9969U,0xA90AU,0xB92BU,
-    0x5AF5U,0x4AD4U,0x7AB7U,0x6A96U,0x1A71U,0x0A50U,0x3A33U,0x2A12U,
-    0xDBFDU,0xCBDCU,0xFBBFU,0xEB9EU,0x9B79U,0x8B58U,0xBB3BU,0xAB1AU,
-    0x6CA6U,0x7C87U,0x4CE4U,0x5CC5U,0x2C22U,0x3C03U,0x0C60U,0x1C41U,
-    0xEDAEU,0xFD8FU,0xCDECU,0xDDCDU,0xAD2AU,0xBD0BU,0x8D68U,0x9D49U,
-    0x7E97U,0x6EB6U,0x5ED5U,0x4EF4U,0x3E13U,0x2E32U,0x1E51U,0x0E70U,
-    0xFF9FU,0xEFBEU,0xDFDDU,0xCFFCU,0xBF1BU,0xAF3AU,0x9F59U,0x8F78U,
-    0x9188U,0x81A9U,0xB1CAU,0xA1EBU,0xD10CU,0xC12DU,0xF14EU,0xE16FU,
-    0x1080U,0x00A1U,0x30C2U,0x20E3U,0x5004U,0x4025U,0x7046U,0x6067U,
-    0x83B9U,0x9398U,0xA3FBU,0xB3DAU,0xC33DU,0xD31CU,0xE37FU,0xF35EU,
-    0x02B1U,0x1290U,0x22F3U,0x32D2U,0x4235U,0x5214U,0x6277U,0x7256U,
-    0xB5EAU,0xA5CBU,0x95A8U,0x8589U,0xF56EU,0xE54FU,0xD52CU,0xC50DU,
-    0x34E2U,0x24C3U,0x14A0U,0x0481U,0x7466U,0x6447U,0x5424U,0x4405U,
-    0xA7DBU,0xB7FAU,0x8799U,0x97B8U,0xE75FU,0xF77EU,0xC71DU,0xD73CU,
-    0x26D3U,0x36F2U,0x0691U,0x16B0U,0x6657U,0x7676U,0x4615U,0x5634U,
-    0xD94CU,0xC96DU,0xF90EU,0xE92FU,0x99C8U,0x89E9U,0xB98AU,0xA9ABU,
-    0x5844U,0x4865U,0x7806U,0x6827U,0x18C0U,0x08E1U,0x3882U,0x28A3U,
-    0xCB7DU,0xDB5CU,0xEB3FU,0xFB1EU,0x8BF9U,0x9BD8U,0xABBBU,0xBB9AU,
-    0x4A75U,0x5A54U,0x6A37U,0x7A16U,0x0AF1U,0x1AD0U,0x2AB3U,0x3A92U,
-    0xFD2EU,0xED0FU,0xDD6CU,0xCD4DU,0xBDAAU,0xAD8BU,0x9DE8U,0x8DC9U,
-    0x7C26U,0x6C07U,0x5C64U,0x4C45U,0x3CA2U,0x2C83U,0x1CE0U,0x0CC1U,
-    0xEF1FU,0xFF3EU,0xCF5DU,0xDF7CU,0xAF9BU,0xBFBAU,0x8FD9U,0x9FF8U,
-    0x6E17U,0x7E36U,0x4E55U,0x5E74U,0x2E93U,0x3EB2U,0x0ED1U,0x1EF0U,
-    };
-
-    while (len > 0)
-    {
-        crc = table[*data ^ (unsigned char)(crc >> 8)] ^ (crc << 8);
-        data++;
-        len--;
-    }
-    return crc;
-}
-
 static void state_machine_thread(void* parameter)
 {
-    //rt_kprintf("SYNCWORDS:\n");
-    for (int i = 0; i < (sizeof(APID_CONFIG)/(2*sizeof(unsigned int))); i++) {
-        SYNCWORDS[i] |= (PACKET_VERSION_NUMBER & 0x07)  << 13;
-        SYNCWORDS[i] |= (PACKET_TYPE & 0x01) << 12;
-        SYNCWORDS[i] |= (APID_CONFIG[i][1] & 0x01) << 11;
-        SYNCWORDS[i] |= (APID_CONFIG[i][0] & 0x7FF);
-        //rt_kprintf("- 0x%04hX\n", (unsigned short)SYNCWORDS[i]);
-    }
-    // buffers
-    rt_uint8_t fsm_init = 0;
-    rt_uint8_t fsm_mode = 0;
-    rt_uint8_t packet_length = 0;
-    rt_uint8_t tmp_data;
-    rt_uint8_t tmp_data2;
     rt_kprintf("Finite State machine started\n");
     while (1)
     {
-        // try to find the start of the CCSDS TM packet (SYNCWORDS)
-        if (fsm_mode==0)
+        // wait for the next datagram, at most until a partial packet expires or a partly filled aggregate is due
+        uint64_t now = osal_time_us();
+        int32_t timeout = reassembly_timeout(now);
+        int32_t forward_timeout = ccsds_forward_timeout(&forward, now);
+        if (forward_timeout != OSAL_WAIT_FOREVER && (timeout == OSAL_WAIT_FOREVER || forward_timeout < timeout))
         {
-            // have not read any data, read two bytes and compare if it matches any SYNCWORDS
-            if (fsm_init==0)
-            {
-                tmp_data = 0;
-                tmp_data2 = 0;
-                //rt_kprintf(" output queue: %d \n", fsm_queue->entry);
-                // try to get first part of the sync word
-                if (rt_mq_recv(incoming_message_queue, &tmp_data, sizeof(rt_uint8_t), RT_WAITING_FOREVER) == RT_EOK)
-                {
-                    // try to get second byte of the syncword
-                    if (rt_mq_recv(incoming_message_queue, &tmp_data2, sizeof(rt_uint8_t), RT_WAITING_FOREVER) == RT_EOK)
-                    {
-                        // look for configured syncword in APID_CONFIG
-                        for (int i = 0; i < (sizeof(APID_CONFIG)/(2*sizeof(unsigned int))); i++)
-                        {
-                            // check if read 2 bytes match any SYNCWORDS
-                            if  ( (tmp_data << 8 | tmp_data2) == SYNCWORDS[i] )
-                            {
-                                // yes, add to queue, advance to mode 2, reset buffers
-                                rt_mq_send(outgoing_message_queue, &tmp_data, sizeof(rt_uint8_t));
-                                rt_mq_send(outgoing_message_queue, &tmp_data2, sizeof(rt_uint8_t));
-                                fsm_mode=2;
-                                tmp_data=0;
-                                tmp_data2=0;
-                                fsm_init=0;
-                                rt_kprintf(" ok: mode 0->2\n");
-                                //rt_kprintf(" output queue: %d \n", fsm_queue->entry);
-                                break;
-                            }
-                            else
-                            {
-                                // no, stay in mode 0 but change fsm_init to 1
-                                // this means two bytes have already been read
-                                // from now on, the first byte will be dropped and replaced by the second one
-                                // second position will be filled with a freshly read byte to make sure every combination
-                                // is tested
-                                fsm_mode = 0;
-                                fsm_init = 1;
-                                rt_kprintf(" decode error, init 0: mode 0->0\n");
-                            }
-                        }
-                    }
-                }
-            }
-            else
-            {
-                // fsm_init==1 means two bytes have already been read and do not match any SYNCWORDS
-                // the first byte will be replaced by the second byte and a new byte will be read for the second byte
-                // then compare starts again
-                tmp_data = tmp_data2;
-                tmp_data2 = 0;
-                //rt_kprintf(" output queue: %d \n", fsm_queue->entry);
-                // try to get second byte of the syncword
-                if (rt_mq_recv(incoming_message_queue, &tmp_data2, sizeof(rt_uint8_t), RT_WAITING_FOREVER) == RT_EOK)
-                {
-                    // look for configured syncword in APID_CONFIG
-                    for (int i = 0; i < (sizeof(APID_CONFIG)/(2*sizeof(unsigned int))); i++)
-                    {
-                        // check if read 2 bytes match any SYNCWORDS
-                        if  ( (tmp_data << 8 | tmp_data2) == SYNCWORDS[i] )
-                        {
-                            // yes, add to queue, advance to mode 2, reset buffers
-                            rt_mq_send(outgoing_message_queue, &tmp_data, sizeof(rt_uint8_t));
-                            rt_mq_send(outgoing_message_queue, &tmp_data2, sizeof(rt_uint8_t));
-                            fsm_mode=2;
-                            tmp_data=0;
-                            tmp_data2=0;
-                            fsm_init=0;
-                            rt_kprintf(" ok: mode 0->2\n");
-                            //rt_kprintf(" output queue: %d \n", fsm_queue->entry);
-                            break;
-                        }
-                        else
-                        {
-                            // this did not match, stay in mode 0, init 1 and keep on shifting position 2 to position 1,
-                            // and place a newly read byte to position 2
-                            fsm_mode = 0;
-                            fsm_init = 1;
-                            rt_kprintf(" decode error, init 1: mode 0->0\n");
-                        }
-                    }
-                }
-            }
+            timeout = forward_timeout;
         }
-        // mode 2, SYNCWORD was found, now read sequence flag and sequence count
-        else if (fsm_mode==2)
+        struct pbuf* p = ccsds_queue_pop(&incoming_queue, timeout);
+        // a new configuration is only checked between datagrams, one load and compare without a lock
+        if (ccsds_conf_reader_changed(&conf_reader) || conf_reader.old != RT_NULL)
         {
-            //rt_kprintf(" start: mode 2\n");
-            // read sequence flag (2 bit), sequence count (14 bit)
-            if (rt_mq_recv(incoming_message_queue, &tmp_data, sizeof(rt_uint8_t), RT_WAITING_FOREVER) == RT_EOK)
-            {
-                //rt_kprintf(" start: mode 2a\n");
-                if (rt_mq_recv(incoming_message_queue, &tmp_data2, sizeof(rt_uint8_t), RT_WAITING_FOREVER) == RT_EOK)
-                {
-                    //rt_kprintf(" start: mode 2b\n");
-                    rt_mq_send(outgoing_message_queue, &tmp_data, sizeof(rt_uint8_t));
-                    rt_mq_send(outgoing_message_queue, &tmp_data2, sizeof(rt_uint8_t));
-                    tmp_data=0;
-                    tmp_data2=0;
-                    fsm_mode = 21;
-                    rt_kprintf(" ok: mode 2->21\n");
-                    //rt_kprintf(" output queue: %d \n", fsm_queue->entry);
-                }
-            }
+            reassembly_config();
         }
-        // mode 21, sequence flag and sequence count were read, read data length field
-        // calculate the length of the data portion without the CRC fields
-        else if (fsm_mode==21)
+        if (p != RT_NULL)
         {
-            //rt_kprintf(" start: mode 21\n");
-            // ... and data length (16 bit) fields
-            if (rt_mq_recv(incoming_message_queue, &tmp_data, sizeof(rt_uint8_t), RT_WAITING_FOREVER) == RT_EOK)
-            {
-                if (rt_mq_recv(incoming_message_queue, &tmp_data2, sizeof(rt_uint8_t), RT_WAITING_FOREVER) == RT_EOK)
-                {
-                    rt_mq_send(outgoing_message_queue, &tmp_data, sizeof(rt_uint8_t));
-                    rt_mq_send(outgoing_message_queue, &tmp_data2, sizeof(rt_uint8_t));
-                    //rt_kprintf(" length: %d \n", (tmp_data << 8 | tmp_data2) );
-                    packet_length = (tmp_data << 8 | tmp_data2) - 1;
-                    // data length, + 2 missing for CRC
-                    tmp_data=0;
-                    tmp_data2=0;
-                    fsm_mode = 22;
-                    rt_kprintf(" ok: mode 21->22 with packet_length: %d\n", packet_length);
-                    //rt_kprintf(" output queue: %d \n", fsm_queue->entry);
-                }
-            }
+            // then hand the datagram back to lwIP
+            reassembly_feed(p, osal_time_us());
+            pbuf_free(p);
         }
-        // mode 22, data length field has been read,
-        // start reading the payload data
-        else if (fsm_mode==22)
+        else
         {
-            //rt_kprintf(" mode 22 reached - data load\n");
-            //rt_kprintf(" pre output queue: %d \n", fsm_queue->entry);
-            for (int i = 0; i < packet_length; i++)
-            {
-                if (rt_mq_recv(incoming_message_queue, &tmp_data, sizeof(rt_uint8_t), RT_WAITING_FOREVER) == RT_EOK)
-                {
-                    //rt_kprintf(" load byte %d of %d\n", i, packet_length);
-                    rt_mq_send(outgoing_message_queue, &tmp_data, sizeof(rt_uint8_t));
-                    tmp_data=0;
-                }
-            }
-            //rt_kprintf(" after output queue: %d \n", fsm_queue->entry);
-            fsm_mode=23;
-            rt_kprintf(" ok: mode 22->23 with %d bytes payload loaded\n", packet_length);
+            reassembly_poll(osal_time_us());
         }
-        // mode 23, payload data has been read,
-        // read the CRC fields,
-        // calculate the real CRC value and compare with the sent ones
-        // if ok, forward data via UDP
-        // if not, reset and start again from mode 0
-        else if (fsm_mode==23)
-        {
-            //rt_kprintf(" mode 23 reached - crc\n");
-            if (rt_mq_recv(incoming_message_queue, &tmp_data, sizeof(rt_uint8_t), RT_WAITING_FOREVER) == RT_EOK)
-            {
-                if (rt_mq_recv(incoming_message_queue, &tmp_data2, sizeof(rt_uint8_t), RT_WAITING_FOREVER) == RT_EOK)
-                {
-                    // insert CRC data
-                    rt_mq_send(outgoing_message_queue, &tmp_data, sizeof(rt_uint8_t));
-                    rt_mq_send(outgoing_message_queue, &tmp_data2, sizeof(rt_uint8_t));
-                    // read how much data exists in the queue
-                    rt_uint8_t output_queue_length = outgoing_message_queue->entry;
-                    //rt_kprintf(" entry output queue: %d \n",output_queue_length);
-                    // if queue is longer than 0 byte
-                    if (output_queue_length > 0)
-                    {
-                        // Transfer data from the output queue to a byte array
-                        rt_uint8_t byte_array[output_queue_length];
-                        for (int i = 0; i < output_queue_length; i++)
-                        {
-                            rt_mq_recv(outgoing_message_queue, &byte_array[i], sizeof(rt_uint8_t), RT_WAITING_NO);
-                        }
-                        //rt_kprintf(" size of byte array: %d \n", sizeof(byte_array));
-                        // calculate real CRC value of received data
-                        rt_uint16_t chkSum = crc16sum(byte_array, output_queue_length-2, 0xFFFF);
-                        //rt_kprintf(" computed crc: %d \n", chkSum);
-                        // show CRC value sent with message
-                        //rt_kprintf(" sent crc: %d \n", tmp_data << 8 | tmp_data2);
-                        // compare if they are identical / message was transfered correctly
-                        if ((tmp_data << 8 | tmp_data2) == chkSum) {
-                            rt_kprintf(" chksum correct (%d), sending data \n", chkSum);
-                            // Send the content via UDP to the preconfigured IP and port
-                            struct udp_pcb* udp_client_pcb = udp_new();
-                            ip4_addr_t dest_ip;
-                            ipaddr_aton(DEST_IP_ADDR, &dest_ip);
-                            struct pbuf* p = pbuf_alloc(PBUF_TRANSPORT, sizeof(byte_array), PBUF_RAM);
-                            if (p != NULL)
-                            {
-                                rt_memcpy(p->payload, byte_array, sizeof(byte_array));
-                                udp_sendto(udp_client_pcb, p, &dest_ip, DEST_UDP_PORT);
-                                pbuf_free(p);
-                            }
-                            //rt_free(byte_array);
-                            udp_remove(udp_client_pcb);
-                        }
-                        else
-                        {
-                            rt_kprintf(" chksum error (sent: %d, computed: %d), restarting \n", (tmp_data << 8 | tmp_data2), chkSum);
-                        }
-                    }
-                    // delete queue content
-                    while (rt_mq_recv(outgoing_message_queue, &tmp_data, sizeof(rt_uint8_t), 1) == RT_EOK) {
-                        tmp_data=0;
-                    }
-                    // reset buffers
-                    tmp_data=0;
-                    tmp_data2=0;
-                    fsm_mode=0;
-                    fsm_init=0;
-                    rt_kprintf(" ok: mode 23->0\n");
-                } // crc2
-            } // crc1
-        } // mode 23
-    } // while
+        // send all packets completed by this datagram in one batch
+        ccsds_forward_flush(&forward, osal_time_us());
+    }
 }
 
 int app_thread_create(void)
@@ -365,12 +214,23 @@ int app_thread_create(void)
     rt_kprintf("CCSDS-TM-FSM\n");
     rt_kprintf("Nico Maas, 2023\n");
     rt_kprintf("www.nico-maas.de\n");
-    rt_kprintf("Packet Version: %d\n", PACKET_VERSION_NUMBER);
-    rt_kprintf("Packet Type: %d\n", PACKET_TYPE);
-    rt_kprintf("Packet APID/Packet has 2nd Header:\n");
-    for (int i = 0; i < (sizeof(APID_CONFIG)/(2*sizeof(unsigned int))); i++) {
-        rt_kprintf("- %d/%d\n", APID_CONFIG[i][0], APID_CONFIG[i][1]);
+
+    // configuration file on the flash file system, the compiled-in settings if there is none
+    struct ccsds_conf* conf = RT_NULL;
+    #ifdef CONFIG_FILE
+    conf = ccsds_conf_load(CONFIG_FILE, RT_NULL);
+    rt_kprintf("Configuration: %s\n", (conf != RT_NULL) ? CONFIG_FILE : "compiled-in");
+    #endif
+    if (conf == RT_NULL)
+    {
+        conf = ccsds_conf_create(PACKET_VERSION_NUMBER, PACKET_TYPE, APID_CONFIG, APID_CONFIG_COUNT);
+        if (conf == RT_NULL)
+        {
+            rt_kprintf("Invalid APID configuration\n");
+            return -1;
+        }
     }
+    ccsds_conf_print(conf);
 
     // Get network interface
     struct netif* netif = netif_default;
@@ -398,13 +258,86 @@ int app_thread_create(void)
     }
     rt_kprintf("\n");
     rt_kprintf("UDP Server: %s, UDP Port: %d\n", ip4addr_ntoa(netif_ip4_addr(netif)), SERVER_UDP_PORT);
-    rt_kprintf("Target System: %s, UDP Port: %d\n", DEST_IP_ADDR, DEST_UDP_PORT);
+    rt_kprintf("Target System: %s, UDP Port: %d (default route)\n", DEST_IP_ADDR, DEST_UDP_PORT);
+
+    // Allocate the packet buffer pool
+    if (ccsds_pool_init(&pool, POOL_CONFIG, POOL_CONFIG_COUNT) != 0)
+    {
+        rt_kprintf("Failed to allocate packet buffer pool\n");
+        return -1;
+    }
+
+    // the routing rules of the configuration file replace ROUTE_CONFIG
+    route_table = conf->routes;
+    conf->routes = RT_NULL;
+    if (route_table == RT_NULL)
+    {
+        route_table = ccsds_route_table_create(ROUTE_CONFIG, ROUTE_CONFIG_COUNT, DEST_IP_ADDR, DEST_UDP_PORT);
+    }
+    if (route_table == RT_NULL)
+    {
+        rt_kprintf("Invalid routing configuration\n");
+        return -1;
+    }
+
+    // publish the configuration with its SYNCWORD lookup and set up the state machine
+    ccsds_conf_publish(conf);
+    ccsds_conf_reader_init(&conf_reader);
+    const struct ccsds_apid_table* apids = &conf_reader.conf->table;
+    // the per-APID counters cover every slot, a configuration loaded later may use more of them
+    if (ccsds_metrics_init(&rx_metrics, "rx", 0) != 0 ||
+        ccsds_metrics_init(&fsm_metrics, "fsm", CCSDS_APID_SLOTS) != 0 ||
+        ccsds_metrics_init(&stats_total, "total", CCSDS_APID_SLOTS) != 0)
+    {
+        rt_kprintf("Failed to allocate metrics\n");
+        return -1;
+    }
+    ccsds_metrics_register(&rx_metrics);
+    ccsds_metrics_register(&fsm_metrics);
+    if (ccsds_forward_init(&forward, &pool, &fsm_metrics, route_table, FORWARD_MTU, FORWARD_FLUSH_MS) != 0)
+    {
+        rt_kprintf("Failed to open the forwarding socket\n");
+        return -1;
+    }
+    if (ccsds_seq_init(&seq, apids, &pool, &fsm_metrics, JOIN_SEGMENTS, ccsds_forward_packet, &forward) != 0)
+    {
+        rt_kprintf("Failed to allocate state machine buffers\n");
+        return -1;
+    }
+    #if FRAME_INPUT
+    if (ccsds_frame_init(&frame, &FRAME_CONFIG, &fsm_metrics) != 0)
+    {
+        rt_kprintf("Invalid frame configuration\n");
+        return -1;
+    }
+    rt_kprintf("TM Transfer Frames of %d bytes, virtual channels 0x%02x\n", FRAME_CONFIG.length, FRAME_VCIDS);
+    for (int i = 0; i < CCSDS_FRAME_VCS; i++)
+    {
+        if ((FRAME_VCIDS & (1 << i)) == 0)
+        {
+            continue;
+        }
+        if (ccsds_fsm_init(&vc_fsm[i], apids, &pool, &fsm_metrics, ccsds_seq_packet, &seq) != 0)
+        {
+            rt_kprintf("Failed to allocate state machine buffers\n");
+            return -1;
+        }
+        ccsds_fsm_set_timeout(&vc_fsm[i], REASSEMBLY_TIMEOUT_MS, 0);
+        ccsds_frame_attach(&frame, i, &vc_fsm[i]);
+    }
+    #else
+    if (ccsds_fsm_init(&fsm, apids, &pool, &fsm_metrics, ccsds_seq_packet, &seq) != 0)
+    {
+        rt_kprintf("Failed to allocate state machine buffers\n");
+        return -1;
+    }
+    ccsds_fsm_set_timeout(&fsm, REASSEMBLY_TIMEOUT_MS, REASSEMBLY_TIMEOUT_RESCAN);
+    #endif
 
-    // Create the incoming message queue
-    incoming_message_queue = rt_mq_create("incoming_message_queue", sizeof(rt_uint8_t), INCOMING_QUEUE_SIZE, RT_IPC_FLAG_FIFO);
-    if (incoming_message_queue == RT_NULL)
+    // Create the incoming datagram ring
+    if (ccsds_queue_init(&incoming_queue, "incoming_queue", incoming_ring, INCOMING_RING_SIZE) != 0)
     {
-        rt_kprintf("Failed to create incoming message queue\n");
+        rt_kprintf("Failed to create incoming queue\n");
         return -1;
     }
 
@@ -425,14 +358,6 @@ int app_thread_create(void)
         return -1;
     }
 
-    // Create the outgoing message queue
-    outgoing_message_queue = rt_mq_create("outgoing_message_queue", sizeof(rt_uint8_t), OUTGOING_QUEUE_SIZE, RT_IPC_FLAG_FIFO);
-    if (outgoing_message_queue == RT_NULL)
-    {
-        rt_kprintf("Failed to create outgoing message queue\n");
-        return -1;
-    }
-
     // Create the state machine thread
     rt_thread_t state_machine_tid = rt_thread_create("state_machine",
                                                     state_machine_thread,
@@ -450,8 +375,136 @@ int app_thread_create(void)
         return -1;
     }
 
+    // Create the stats publisher thread
+    #if STATS_INTERVAL_MS > 0
+    stats_publisher.dest_ip = DEST_IP_ADDR;
+    stats_publisher.dest_port = STATS_UDP_PORT;
+    stats_publisher.interval_ms = STATS_INTERVAL_MS;
+    // 4 KiB stack: the JSON is formatted with vsnprintf of the C library, which needs about 1.5 KiB for 64 bit conversions
+    rt_thread_t stats_tid = rt_thread_create("stats",
+                                             ccsds_metrics_thread,
+                                             &stats_publisher,
+                                             4096,
+                                             RT_THREAD_PRIORITY_MAX - 3,
+                                             10);
+    if (stats_tid != RT_NULL)
+    {
+        rt_thread_startup(stats_tid);
+    }
+    else
+    {
+        rt_kprintf("Failed to create stats thread\n");
+        return -1;
+    }
+    #endif
+
+    // Create the trace drain thread with the lowest priority, so printing never delays reassembly
+    #if TRACE_DRAIN_MS > 0
+    // 2 KiB stack: a console line (RT_CONSOLEBUF_SIZE) and rt_vsnprintf with 32 bit conversions
+    rt_thread_t trace_tid = rt_thread_create("trace",
+                                             ccsds_trace_thread,
+                                             (void*)TRACE_DRAIN_MS,
+                                             2048,
+                                             RT_THREAD_PRIORITY_MAX - 2,
+                                             10);
+    if (trace_tid != RT_NULL)
+    {
+        rt_thread_startup(trace_tid);
+    }
+    else
+    {
+        rt_kprintf("Failed to create trace thread\n");
+        return -1;
+    }
+    #endif
+
     return 0;
 }
 
+// print the events recorded since the last dump
+static void ccsds_trace(void)
+{
+    ccsds_trace_dump();
+}
+MSH_CMD_EXPORT(ccsds_trace, print the recorded trace events)
+
+// print the counters and latency histograms
+static void ccsds_stats(void)
+{
+    struct ccsds_conf* conf = ccsds_conf_acquire();
+    ccsds_metrics_sum(&stats_total);
+    ccsds_metrics_print(&stats_total, &conf->table);
+    ccsds_conf_release(conf);
+}
+MSH_CMD_EXPORT(ccsds_stats, print packet counters and latency histograms)
+
+// print the routing table or replace it, e.g. ccsds_route 0-99 192.168.178.4:4712 ; * 192.168.178.3:4712
+// the reassembly keeps running, the state machine thread switches to the new table with its next flush
+static void ccsds_route(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        ccsds_route_table_print(route_table);
+        return;
+    }
+    // the arguments form the rules again, ';' separates them
+    char text[256];
+    size_t len = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        size_t arg_len = rt_strlen(argv[i]);
+        if (len + arg_len + 2 > sizeof(text))
+        {
+            rt_kprintf("Routing rules too long\n");
+            return;
+        }
+        rt_memcpy(&text[len], argv[i], arg_len);
+        len += arg_len;
+        text[len++] = ' ';
+    }
+    text[len] = '\0';
+    struct ccsds_route_table* table = ccsds_route_table_parse(text);
+    if (table == RT_NULL)
+    {
+        rt_kprintf("Invalid routing rules\n");
+        return;
+    }
+    route_table = table;
+    ccsds_forward_set_routes(&forward, table);
+    ccsds_route_table_print(table);
+}
+MSH_CMD_EXPORT(ccsds_route, print or replace the APID routing table)
+
+// print the configuration in use or load one from the file system, e.g. ccsds_config /flash/ccsds.ini
+// the reassembly keeps running, the state machine thread switches to it between two datagrams
+static void ccsds_config(int argc, char** argv)
+{
+    struct ccsds_conf* current = ccsds_conf_acquire();
+    if (argc < 2)
+    {
+        ccsds_conf_print(current);
+        ccsds_conf_release(current);
+        return;
+    }
+    // settings the file leaves out stay as they are
+    struct ccsds_conf* conf = ccsds_conf_load(argv[1], current);
+    ccsds_conf_release(current);
+    if (conf == RT_NULL)
+    {
+        rt_kprintf("Failed to load %s\n", argv[1]);
+        return;
+    }
+    if (conf->routes != RT_NULL)
+    {
+        route_table = conf->routes;
+        conf->routes = RT_NULL;
+        ccsds_forward_set_routes(&forward, route_table);
+        ccsds_route_table_print(route_table);
+    }
+    ccsds_conf_print(conf);
+    ccsds_conf_publish(conf);
+}
+MSH_CMD_EXPORT(ccsds_config, print or load the runtime configuration)
+
 // start application
 INIT_APP_EXPORT(app_thread_create);
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     pool sized for joined units
+ */
+
+#ifndef CCSDS_CONFIG_H
+#define CCSDS_CONFIG_H
+
+#include "ccsds_apid.h"
+#include "ccsds_frame.h"
+#include "ccsds_route.h"
+
+// define SERVER_IP_ADDR, SERVER_NETMASK and SERVER_GATEWAY_IP to manually set IP address
+// or leave commented out to activate DHCP Client
+//#define SERVER_IP_ADDR      "192.168.178.2"
+//#define SERVER_NETMASK      "255.255.255.0"
+//#define SERVER_GATEWAY_IP   "192.168.178.1"
+#define SERVER_UDP_PORT     4711
+// default destination of the packets of all APIDs ROUTE_CONFIG does not route
+#define DEST_IP_ADDR        "192.168.178.3"
+#define DEST_UDP_PORT       4712
+// destinations per APID: tuples of first and last APID [0-2047], IP and UDP port, at most 16 different destinations
+// APIDs in several rules are sent to all their destinations, e.g. all housekeeping to a second computer:
+// {{0, 99, "192.168.178.4", 4712}, {0, 2047, "192.168.178.3", 4712}}
+// the msh command ccsds_route prints the table in use or replaces it at runtime
+static const struct ccsds_route_config ROUTE_CONFIG[] = {{0, 2047, DEST_IP_ADDR, DEST_UDP_PORT}};
+#define ROUTE_CONFIG_COUNT  (sizeof(ROUTE_CONFIG)/sizeof(ROUTE_CONFIG[0]))
+// pack small packets back to back into datagrams of up to FORWARD_MTU bytes (0: one datagram per packet),
+// a partly filled datagram is sent FORWARD_FLUSH_MS after its first packet at the latest
+#define FORWARD_MTU         0
+#define FORWARD_FLUSH_MS    10
+
+// runtime configuration file (INI, see ccsds_conf.h) on the file system of the board, loaded at startup
+// instead of PACKET_VERSION_NUMBER, PACKET_TYPE, APID_CONFIG and ROUTE_CONFIG if it exists,
+// the msh command ccsds_config loads a new one without stopping the reassembly
+// comment out to always use the compiled-in settings below
+#define CONFIG_FILE         "/ccsds.ini"
+
+// CCSDS configuration
+#define PACKET_VERSION_NUMBER   0   // Default: 0
+#define PACKET_TYPE             0   // Telemetry Packet: 0
+// all allowed APID numbers [0-2047] including if the packet is going to have a 2nd header (1) or not (0),
+// if the packet ends with a CRC16 (1) or not (0) and the largest expected packet length in bytes (0: no limit)
+static const struct ccsds_apid_config APID_CONFIG[] = {{123, 1, 1, 0}, {815, 1, 1, 0}, {2047, 0, 1, 0}};
+#define APID_CONFIG_COUNT   (sizeof(APID_CONFIG)/sizeof(APID_CONFIG[0]))
+// join segmented user data (sequence flags first/continuation/last) into one packet before forwarding (1)
+// or forward every segment on its own (0)
+#define JOIN_SEGMENTS       1
+// a partial packet which gets no new bytes for REASSEMBLY_TIMEOUT_MS (e.g. the downlink dropped in the middle of it)
+// expires and the state machine hunts for the next SYNCWORD (0: wait forever)
+// its bytes are rescanned for complete packets (REASSEMBLY_TIMEOUT_RESCAN 1) or discarded (0)
+#define REASSEMBLY_TIMEOUT_MS       1000
+#define REASSEMBLY_TIMEOUT_RESCAN   1
+
+// TM Transfer Frame input (CCSDS 132.0-B): the received bytes are frames carrying the packets (1)
+// or a plain stream of Space Packets (0)
+// frame length in bytes without ASM, ASM in front of every frame (1) or whole frames per datagram (0),
+// frames end with a FECF (1) or not (0), spacecraft id of accepted frames (-1: all)
+#define FRAME_INPUT     0
+static const struct ccsds_frame_config FRAME_CONFIG = {1115, 1, 1, -1};
+// bit per virtual channel [0-7] whose packets are reassembled, every one gets a state machine of its own,
+// frames of other virtual channels are dropped
+#define FRAME_VCIDS     0x01
+
+// counters and latency histograms are sent as one JSON datagram every STATS_INTERVAL_MS (0: never)
+// to DEST_IP_ADDR:STATS_UDP_PORT, the msh command ccsds_stats prints them to the console
+#define STATS_UDP_PORT      4713
+#define STATS_INTERVAL_MS   1000
+
+// interval in ms in which a low priority thread prints the trace ring to the console
+// 0: no drain thread, the trace is only printed on demand (msh command ccsds_trace)
+// the recorded events are selected at compile time with CCSDS_TRACE_LEVEL (see ccsds_trace.h, errors only by default)
+#define TRACE_DRAIN_MS      100
+
+// packet buffer pool, allocated once at startup
+// tuples of buffer size in bytes and number of buffers, ascending by size
+// the largest class limits the packet length, 65542 bytes (CCSDS_MAX_PACKET_SIZE) allows every Space Packet
+// a buffer is held by the packet a state machine reassembles, by every packet waiting to be forwarded and, with
+// JOIN_SEGMENTS, by every open segmented unit: a unit takes a buffer of the max_length of its APID, of the largest
+// class if that is 0, so the largest class needs one buffer per such APID on top of the ones for long packets
+// (an APID with max_length 4096 takes one of the 4096 byte class instead)
+static const unsigned int POOL_CONFIG[][2] = {{512, 16}, {4096, 8}, {65542, 2 + JOIN_SEGMENTS * APID_CONFIG_COUNT}};
+#define POOL_CONFIG_COUNT   (sizeof(POOL_CONFIG)/(2*sizeof(unsigned int)))
+
+#endif
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     reject more APIDs than slots
+ * 2026-10-17   Nico Maas     reject APIDs configured twice
+ * 2026-10-17   Nico Maas     check candidates inside the bulk scan
+ */
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "ccsds_apid.h"
+
+int ccsds_apid_table_init(struct ccsds_apid_table* table, unsigned int packet_version, unsigned int packet_type,
+                          const struct ccsds_apid_config* config, unsigned int count)
+{
+    memset(table, 0, sizeof(*table));
+    // nothing configured, no byte can match
+    table->scan_value = 1;
+    if (count > CCSDS_APID_SLOTS)
+    {
+        return -1;
+    }
+    table->config = config;
+    table->count = count;
+    uint8_t agree = 0xFF;
+    uint8_t first = 0;
+    unsigned int used = 0;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (config[i].apid > 0x7FF)
+        {
+            continue;
+        }
+        uint16_t word = ccsds_syncword(packet_version, packet_type, config[i].secondary_header, config[i].apid);
+        // the slot is found by the APID alone, an APID configured twice (e.g. with and without secondary header)
+        // would take the rules of the other entry
+        if (table->apids[config[i].apid >> 5] & (1UL << (config[i].apid & 31)))
+        {
+            memset(table, 0, sizeof(*table));
+            table->scan_value = 1;
+            return -1;
+        }
+        table->apids[config[i].apid >> 5] |= 1UL << (config[i].apid & 31);
+        table->syncwords[word >> 5] |= 1UL << (word & 31);
+        table->slot[word & 0x7FF] = i;
+        table->first_byte[word >> 8] = 1;
+        if (used++ == 0)
+        {
+            first = word >> 8;
+        }
+        agree &= ~((word >> 8) ^ first);
+    }
+    if (used > 0)
+    {
+        table->scan_mask = agree;
+        table->scan_value = first & agree;
+    }
+    return 0;
+}
+
+// offset of the first byte which can start a configured SYNCWORD, len if there is none
+// the vector (or word) compare with scan_mask/scan_value rejects most bytes in bulk, the bytes it lets through
+// are checked with first_byte right here, so a fill the mask cannot tell apart (e.g. zeros) does not end
+// the bulk loop at every byte
+size_t ccsds_apid_scan(const struct ccsds_apid_table* table, const uint8_t* data, size_t len)
+{
+    const uint8_t mask = table->scan_mask;
+    const uint8_t value = table->scan_value;
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i vmask = _mm_set1_epi8((char)mask);
+    const __m128i vvalue = _mm_set1_epi8((char)value);
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+        unsigned int bits = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(v, vmask), vvalue));
+        while (bits != 0)
+        {
+            size_t j = i + __builtin_ctz(bits);
+            if (table->first_byte[data[j]])
+            {
+                return j;
+            }
+            bits &= bits - 1;
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t vmask = vdupq_n_u8(mask);
+    const uint8x16_t vvalue = vdupq_n_u8(value);
+    for (; i + 16 <= len; i += 16)
+    {
+        uint8x16_t eq = vceqq_u8(vandq_u8(vld1q_u8(data + i), vmask), vvalue);
+        // narrow to 4 bit per byte to get a 64 bit mask
+        uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        while (bits != 0)
+        {
+            unsigned int nibble = __builtin_ctzll(bits) >> 2;
+            if (table->first_byte[data[i + nibble]])
+            {
+                return i + nibble;
+            }
+            bits &= ~(0xFULL << (nibble * 4));
+        }
+    }
+#else
+    // word-at-a-time: a byte matches if (byte & mask) ^ value is zero
+    const size_t ones = (size_t)-1 / 0xFF;
+    const size_t wmask = ones * mask;
+    const size_t wvalue = ones * value;
+    for (; i + sizeof(size_t) <= len; i += sizeof(size_t))
+    {
+        size_t word;
+        memcpy(&word, data + i, sizeof(word));
+        word = (word & wmask) ^ wvalue;
+        if (((word - ones) & ~word & (ones << 7)) != 0)
+        {
+            for (size_t j = i; j < i + sizeof(size_t); j++)
+            {
+                if (table->first_byte[data[j]])
+                {
+                    return j;
+                }
+            }
+        }
+    }
+#endif
+    for (; i < len; i++)
+    {
+        if (table->first_byte[data[i]])
+        {
+            return i;
+        }
+    }
+    return len;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     a slot for every APID
+ */
+
+#ifndef CCSDS_APID_H
+#define CCSDS_APID_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// configured APIDs of one table, the per-APID state (counters, sequence contexts) is allocated for all of them
+// by default every APID can be configured, a compiler define of fewer slots saves about 150 bytes of RAM per slot
+// on small boards (the same value for the whole build, it sets the size of struct ccsds_conf)
+#ifndef CCSDS_APID_SLOTS
+#define CCSDS_APID_SLOTS    2048
+#endif
+// apid of a slot without configuration (left by an APID removed at runtime)
+#define CCSDS_APID_UNUSED   0xFFFF
+
+// configuration of one APID
+struct ccsds_apid_config
+{
+    uint16_t apid;              // [0-2047], CCSDS_APID_UNUSED for an empty slot
+    uint8_t secondary_header;   // packet has a 2nd header (1) or not (0)
+    uint8_t crc;                // packet ends with a CRC16 (1) or not (0)
+    uint32_t max_length;        // largest expected packet in bytes incl. header, 0 = largest pool buffer
+};
+
+// lookup structure generated out of the APID configuration
+// every possible first header word (SYNCWORD) has one bit, so checking a candidate costs one bit test
+// independent of the number of configured APIDs, a hit also yields the configuration of the APID
+struct ccsds_apid_table
+{
+    uint32_t syncwords[65536 / 32];                 // bit set for every configured SYNCWORD
+    uint32_t apids[2048 / 32];                      // bit set for every configured APID
+    uint16_t slot[2048];                            // APID -> index into config, valid if its SYNCWORD bit is set
+    uint8_t first_byte[256];                        // 1 for every first byte of a configured SYNCWORD
+    uint8_t scan_mask;                              // bits all first bytes of configured SYNCWORDS agree on ...
+    uint8_t scan_value;                             // ... and their value, used to skip bytes in bulk
+    const struct ccsds_apid_config* config;
+    unsigned int count;
+};
+
+// first 16 bit of the primary header
+static inline uint16_t ccsds_syncword(unsigned int packet_version, unsigned int packet_type,
+                                      unsigned int secondary_header, unsigned int apid)
+{
+    return (uint16_t)(((packet_version & 0x07) << 13) | ((packet_type & 0x01) << 12) |
+                      ((secondary_header & 0x01) << 11) | (apid & 0x7FF));
+}
+
+// generate the lookup structure, config has to stay valid as long as the table is used
+// the index of an APID in config is its slot, empty slots are skipped
+// returns -1 if count exceeds CCSDS_APID_SLOTS or an APID is configured twice, the table then matches nothing
+int ccsds_apid_table_init(struct ccsds_apid_table* table, unsigned int packet_version, unsigned int packet_type,
+                          const struct ccsds_apid_config* config, unsigned int count);
+
+// configuration of the APID if word is a configured SYNCWORD, NULL otherwise
+static inline const struct ccsds_apid_config* ccsds_apid_lookup(const struct ccsds_apid_table* table, uint16_t word)
+{
+    if ((table->syncwords[word >> 5] & (1UL << (word & 31))) == 0)
+    {
+        return NULL;
+    }
+    return &table->config[table->slot[word & 0x7FF]];
+}
+
+// offset of the first byte in data which can start a configured SYNCWORD, len if there is none
+// uses SSE2 or NEON where available and a word-at-a-time scan otherwise
+size_t ccsds_apid_scan(const struct ccsds_apid_table* table, const uint8_t* data, size_t len);
+
+#endif
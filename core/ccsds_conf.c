@@ -0,0 +1,440 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     APID list on the heap, a slot for every APID
+ */
+
+#include <string.h>
+
+#include "ccsds_conf.h"
+#include "ccsds_pool.h"
+#include "osal.h"
+
+// sections of the INI text
+enum conf_section
+{
+    CONF_SECTION_NONE,
+    CONF_SECTION_PACKET,
+    CONF_SECTION_APIDS,
+    CONF_SECTION_ROUTES,
+};
+
+// the published configuration, holds a reference of its own
+static struct ccsds_conf* conf_current;
+// only taken to publish or acquire a configuration, never on the reassembly path
+static osal_mutex_t conf_lock;
+
+static struct ccsds_conf* conf_alloc(void)
+{
+    struct ccsds_conf* conf = osal_malloc(sizeof(struct ccsds_conf));
+    if (conf == NULL)
+    {
+        return NULL;
+    }
+    memset(conf, 0, sizeof(*conf));
+    conf->refs = 1;
+    for (unsigned int i = 0; i < CCSDS_APID_SLOTS; i++)
+    {
+        conf->apids[i].apid = CCSDS_APID_UNUSED;
+    }
+    return conf;
+}
+
+static void conf_free(struct ccsds_conf* conf)
+{
+    if (conf->routes != NULL)
+    {
+        ccsds_route_table_free(conf->routes);
+    }
+    osal_free(conf);
+}
+
+// generate the lookup out of the slots, the table covers the slots up to the last used one
+static int conf_compile(struct ccsds_conf* conf)
+{
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < CCSDS_APID_SLOTS; i++)
+    {
+        if (conf->apids[i].apid != CCSDS_APID_UNUSED)
+        {
+            count = i + 1;
+        }
+    }
+    return ccsds_apid_table_init(&conf->table, conf->packet_version, conf->packet_type, conf->apids, count);
+}
+
+struct ccsds_conf* ccsds_conf_create(unsigned int packet_version, unsigned int packet_type,
+                                     const struct ccsds_apid_config* config, unsigned int count)
+{
+    if (count > CCSDS_APID_SLOTS)
+    {
+        return NULL;
+    }
+    struct ccsds_conf* conf = conf_alloc();
+    if (conf == NULL)
+    {
+        return NULL;
+    }
+    conf->packet_version = packet_version & 0x07;
+    conf->packet_type = packet_type & 0x01;
+    memcpy(conf->apids, config, count * sizeof(*config));
+    if (conf_compile(conf) != 0)
+    {
+        conf_free(conf);
+        return NULL;
+    }
+    return conf;
+}
+
+// unsigned decimal number up to max, skipping blanks in front of it, -1 if there is none or it is too large
+static int conf_number(const char** text, const char* end, unsigned long max, unsigned long* value)
+{
+    const char* p = *text;
+    while (p < end && (*p == ' ' || *p == '\t'))
+    {
+        p++;
+    }
+    if (p == end || *p < '0' || *p > '9')
+    {
+        return -1;
+    }
+    *value = 0;
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+        *value = *value * 10 + (*p++ - '0');
+        if (*value > max)
+        {
+            return -1;
+        }
+    }
+    *text = p;
+    return 0;
+}
+
+// nothing but blanks left in the line
+static int conf_line_end(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t'))
+    {
+        p++;
+    }
+    return (p == end) ? 0 : -1;
+}
+
+// "key = value" of the [packet] section
+static int conf_parse_packet(struct ccsds_conf* conf, const char* line, const char* end)
+{
+    const char* equal = memchr(line, '=', end - line);
+    if (equal == NULL)
+    {
+        return -1;
+    }
+    size_t len = equal - line;
+    while (len > 0 && (line[len - 1] == ' ' || line[len - 1] == '\t'))
+    {
+        len--;
+    }
+    const char* p = equal + 1;
+    unsigned long value;
+    if (len == 7 && memcmp(line, "version", 7) == 0 && conf_number(&p, end, 7, &value) == 0)
+    {
+        conf->packet_version = (uint8_t)value;
+    }
+    else if (len == 4 && memcmp(line, "type", 4) == 0 && conf_number(&p, end, 1, &value) == 0)
+    {
+        conf->packet_type = (uint8_t)value;
+    }
+    else
+    {
+        return -1;
+    }
+    return conf_line_end(p, end);
+}
+
+// "apid = secondary_header crc max_length" of the [apids] section
+static int conf_parse_apid(struct ccsds_apid_config* config, const char* line, const char* end)
+{
+    const char* p = line;
+    unsigned long apid, secondary_header, crc, max_length;
+    if (conf_number(&p, end, 0x7FF, &apid) != 0)
+    {
+        return -1;
+    }
+    while (p < end && (*p == ' ' || *p == '\t'))
+    {
+        p++;
+    }
+    if (p == end || *p++ != '=' ||
+        conf_number(&p, end, 1, &secondary_header) != 0 ||
+        conf_number(&p, end, 1, &crc) != 0 ||
+        conf_number(&p, end, CCSDS_MAX_PACKET_SIZE, &max_length) != 0)
+    {
+        return -1;
+    }
+    config->apid = (uint16_t)apid;
+    config->secondary_header = (uint8_t)secondary_header;
+    config->crc = (uint8_t)crc;
+    config->max_length = (uint32_t)max_length;
+    return conf_line_end(p, end);
+}
+
+// put the APIDs of the [apids] section into slots, the ones already known keep theirs
+static int conf_assign_slots(struct ccsds_conf* conf, const struct ccsds_apid_config* list, unsigned int count,
+                             const struct ccsds_conf* prev)
+{
+    // bit per entry of list which kept its slot
+    uint32_t placed[(CCSDS_APID_SLOTS + 31) / 32] = { 0 };
+    for (unsigned int i = 0; i < CCSDS_APID_SLOTS; i++)
+    {
+        conf->apids[i].apid = CCSDS_APID_UNUSED;
+    }
+    for (unsigned int i = 0; i < count && prev != NULL; i++)
+    {
+        // the table of prev knows the slot of each of its APIDs
+        uint16_t apid = list[i].apid;
+        if (prev->table.apids[apid >> 5] & (1UL << (apid & 31)))
+        {
+            conf->apids[prev->table.slot[apid]] = list[i];
+            placed[i >> 5] |= 1UL << (i & 31);
+        }
+    }
+    unsigned int slot = 0;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (placed[i >> 5] & (1UL << (i & 31)))
+        {
+            continue;
+        }
+        while (slot < CCSDS_APID_SLOTS && conf->apids[slot].apid != CCSDS_APID_UNUSED)
+        {
+            slot++;
+        }
+        if (slot == CCSDS_APID_SLOTS)
+        {
+            return -1;
+        }
+        conf->apids[slot] = list[i];
+    }
+    return 0;
+}
+
+struct ccsds_conf* ccsds_conf_parse(const char* text, const struct ccsds_conf* prev)
+{
+    struct ccsds_conf* conf = conf_alloc();
+    // rules of the [routes] section, never longer than the text
+    char* routes = osal_malloc(strlen(text) + 1);
+    // APIDs of the [apids] section, and a bit per APID to find repeated ones
+    struct ccsds_apid_config* list = osal_malloc(CCSDS_APID_SLOTS * sizeof(struct ccsds_apid_config));
+    uint32_t seen[2048 / 32] = { 0 };
+    unsigned int count = 0;
+    int apids_given = 0;
+    int routes_given = 0;
+    size_t routes_len = 0;
+    int error = (conf == NULL || routes == NULL || list == NULL);
+    if (!error && prev != NULL)
+    {
+        conf->packet_version = prev->packet_version;
+        conf->packet_type = prev->packet_type;
+        memcpy(conf->apids, prev->apids, sizeof(conf->apids));
+    }
+    enum conf_section section = CONF_SECTION_NONE;
+    while (!error && *text != '\0')
+    {
+        const char* line = text;
+        const char* end = strchr(line, '\n');
+        if (end == NULL)
+        {
+            end = line + strlen(line);
+        }
+        text = (*end == '\n') ? end + 1 : end;
+        while (line < end && (*line == ' ' || *line == '\t'))
+        {
+            line++;
+        }
+        // the routing rules are passed on as they are, ccsds_route_table_parse knows their comments
+        if (section == CONF_SECTION_ROUTES && line < end && *line != '[')
+        {
+            memcpy(&routes[routes_len], line, end - line);
+            routes_len += end - line;
+            routes[routes_len++] = '\n';
+            continue;
+        }
+        // comments and blank lines
+        const char* comment = line;
+        while (comment < end && *comment != '#' && *comment != ';')
+        {
+            comment++;
+        }
+        end = comment;
+        while (end > line && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+        {
+            end--;
+        }
+        if (line == end)
+        {
+            continue;
+        }
+        if (*line == '[')
+        {
+            size_t len = end - line;
+            if (len == 8 && memcmp(line, "[packet]", 8) == 0)
+            {
+                section = CONF_SECTION_PACKET;
+            }
+            else if (len == 7 && memcmp(line, "[apids]", 7) == 0)
+            {
+                section = CONF_SECTION_APIDS;
+                apids_given = 1;
+            }
+            else if (len == 8 && memcmp(line, "[routes]", 8) == 0)
+            {
+                section = CONF_SECTION_ROUTES;
+                routes_given = 1;
+            }
+            else
+            {
+                error = 1;
+            }
+        }
+        else if (section == CONF_SECTION_PACKET)
+        {
+            error = (conf_parse_packet(conf, line, end) != 0);
+        }
+        else if (section == CONF_SECTION_APIDS)
+        {
+            error = (count == CCSDS_APID_SLOTS || conf_parse_apid(&list[count], line, end) != 0);
+            if (!error)
+            {
+                // every APID once
+                uint16_t apid = list[count].apid;
+                error = (seen[apid >> 5] & (1UL << (apid & 31))) != 0;
+                seen[apid >> 5] |= 1UL << (apid & 31);
+            }
+            count++;
+        }
+        else
+        {
+            error = 1;
+        }
+    }
+    if (!error && apids_given)
+    {
+        error = (conf_assign_slots(conf, list, count, prev) != 0);
+    }
+    if (!error && routes_given)
+    {
+        routes[routes_len] = '\0';
+        conf->routes = ccsds_route_table_parse(routes);
+        error = (conf->routes == NULL);
+    }
+    osal_free(routes);
+    osal_free(list);
+    if (!error)
+    {
+        error = (conf_compile(conf) != 0);
+    }
+    if (error)
+    {
+        if (conf != NULL)
+        {
+            conf_free(conf);
+        }
+        return NULL;
+    }
+    return conf;
+}
+
+struct ccsds_conf* ccsds_conf_load(const char* path, const struct ccsds_conf* prev)
+{
+    char* text = osal_file_read(path, CCSDS_CONF_FILE_SIZE);
+    if (text == NULL)
+    {
+        return NULL;
+    }
+    struct ccsds_conf* conf = ccsds_conf_parse(text, prev);
+    osal_free(text);
+    return conf;
+}
+
+void ccsds_conf_publish(struct ccsds_conf* conf)
+{
+    if (conf_lock == NULL)
+    {
+        conf_lock = osal_mutex_create("conf");
+    }
+    osal_mutex_lock(conf_lock);
+    struct ccsds_conf* old = conf_current;
+    __atomic_store_n(&conf_current, conf, __ATOMIC_RELEASE);
+    osal_mutex_unlock(conf_lock);
+    // threads still using the old configuration hold references of their own
+    if (old != NULL)
+    {
+        ccsds_conf_release(old);
+    }
+}
+
+struct ccsds_conf* ccsds_conf_acquire(void)
+{
+    osal_mutex_lock(conf_lock);
+    struct ccsds_conf* conf = conf_current;
+    __atomic_add_fetch(&conf->refs, 1, __ATOMIC_RELAXED);
+    osal_mutex_unlock(conf_lock);
+    return conf;
+}
+
+void ccsds_conf_release(struct ccsds_conf* conf)
+{
+    if (__atomic_sub_fetch(&conf->refs, 1, __ATOMIC_ACQ_REL) == 0)
+    {
+        conf_free(conf);
+    }
+}
+
+void ccsds_conf_print(const struct ccsds_conf* conf)
+{
+    osal_printf("Packet Version: %u\n", conf->packet_version);
+    osal_printf("Packet Type: %u\n", conf->packet_type);
+    osal_printf("Packet APID/Packet has 2nd Header/Packet has CRC/max. length:\n");
+    for (unsigned int i = 0; i < conf->table.count; i++)
+    {
+        const struct ccsds_apid_config* apid = &conf->apids[i];
+        if (apid->apid != CCSDS_APID_UNUSED)
+        {
+            osal_printf("- %u/%u/%u/%lu\n", apid->apid, apid->secondary_header, apid->crc, (unsigned long)apid->max_length);
+        }
+    }
+}
+
+void ccsds_conf_reader_init(struct ccsds_conf_reader* reader)
+{
+    reader->conf = ccsds_conf_acquire();
+    reader->old = NULL;
+}
+
+int ccsds_conf_reader_changed(const struct ccsds_conf_reader* reader)
+{
+    return __atomic_load_n(&conf_current, __ATOMIC_ACQUIRE) != reader->conf;
+}
+
+struct ccsds_conf* ccsds_conf_reader_update(struct ccsds_conf_reader* reader)
+{
+    if (reader->old != NULL || !ccsds_conf_reader_changed(reader))
+    {
+        return NULL;
+    }
+    reader->old = reader->conf;
+    reader->conf = ccsds_conf_acquire();
+    return reader->conf;
+}
+
+void ccsds_conf_reader_retire(struct ccsds_conf_reader* reader)
+{
+    if (reader->old != NULL)
+    {
+        ccsds_conf_release(reader->old);
+        reader->old = NULL;
+    }
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ */
+
+#ifndef CCSDS_CONF_H
+#define CCSDS_CONF_H
+
+#include <stdint.h>
+
+#include "ccsds_apid.h"
+#include "ccsds_route.h"
+
+// largest configuration file
+#define CCSDS_CONF_FILE_SIZE    (16 * 1024)
+
+// configuration loaded at runtime, compiled into the lookup tables once when it is loaded
+// a published configuration is never changed: a new one replaces it as a whole (RCU style), the hot path
+// only reads the pointer of the current one, and every thread keeps using its copy until its packets are done
+struct ccsds_conf
+{
+    uint32_t refs;                                  // holders, freed with the last ccsds_conf_release
+    uint8_t packet_version;
+    uint8_t packet_type;
+    struct ccsds_apid_config apids[CCSDS_APID_SLOTS];   // indexed by slot, CCSDS_APID_UNUSED for empty ones
+    struct ccsds_apid_table table;                  // SYNCWORD lookup generated out of apids
+    struct ccsds_route_table* routes;               // [routes] of the text, NULL if it has none, taken by the loader
+};
+
+// configuration of one thread: it starts new packets with conf while partial packets may still use old
+struct ccsds_conf_reader
+{
+    struct ccsds_conf* conf;
+    struct ccsds_conf* old;
+};
+
+// configuration out of the compiled-in settings (ccsds_config.h), NULL if there are too many APIDs
+struct ccsds_conf* ccsds_conf_create(unsigned int packet_version, unsigned int packet_type,
+                                     const struct ccsds_apid_config* config, unsigned int count);
+
+// configuration out of INI text:
+//   [packet]  version = 0 / type = 0
+//   [apids]   one line per APID "apid = secondary_header crc max_length", the section replaces all APIDs
+//   [routes]  routing rules as for ccsds_route_table_parse, one per line
+// values missing in the text are taken from prev (if not NULL), an APID of prev keeps its slot so its
+// counters and sequence context go on, new APIDs take free slots
+// returns NULL on a syntax error, an invalid value or too many APIDs
+struct ccsds_conf* ccsds_conf_parse(const char* text, const struct ccsds_conf* prev);
+
+// read the INI file with osal_file_read and parse it, NULL if that fails
+struct ccsds_conf* ccsds_conf_load(const char* path, const struct ccsds_conf* prev);
+
+// make conf the current configuration, takes over the reference of the caller
+// the first call has to happen before any other thread uses the configuration
+void ccsds_conf_publish(struct ccsds_conf* conf);
+
+// reference to the current configuration, slow path (takes a lock), release it with ccsds_conf_release
+struct ccsds_conf* ccsds_conf_acquire(void);
+void ccsds_conf_release(struct ccsds_conf* conf);
+
+// print the configuration to the console
+void ccsds_conf_print(const struct ccsds_conf* conf);
+
+// take the current configuration as the first one of a thread
+void ccsds_conf_reader_init(struct ccsds_conf_reader* reader);
+
+// a configuration newer than the one of the reader was published: one load and compare, no lock
+int ccsds_conf_reader_changed(const struct ccsds_conf_reader* reader);
+
+// take over a newly published configuration if the previous switch has been retired,
+// returns it (the caller hands its table to its state machines with ccsds_fsm_set_apids) or NULL
+struct ccsds_conf* ccsds_conf_reader_update(struct ccsds_conf_reader* reader);
+
+// release the previous configuration once no partial packet of the thread uses it any more
+void ccsds_conf_reader_retire(struct ccsds_conf_reader* reader);
+
+#endif
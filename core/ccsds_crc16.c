@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     copy and checksum in one pass
+ * 2026-10-17   Nico Maas     fall back to slice8 if the fixed implementation is not supported
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CRC16_HAVE_PCLMUL   1
+#endif
+
+#include <string.h>
+
+#include "ccsds_crc16.h"
+#include "osal.h"
+
+// CRC16-CCITT-False Checksum, table for one byte
+static const uint16_t crc16_table[256] = {
+    0x0000U,0x1021U,0x2042U,0x3063U,0x4084U,0x50A5U,0x60C6U,0x70E7U,
+    0x8108U,0x9129U,0xA14AU,0xB16BU,0xC18CU,0xD1ADU,0xE1CEU,0xF1EFU,
+    0x1231U,0x0210U,0x3273U,0x2252U,0x52B5U,0x4294U,0x72F7U,0x62D6U,
+    0x9339U,0x8318U,0xB37BU,0xA35AU,0xD3BDU,0xC39CU,0xF3FFU,0xE3DEU,
+    0x2462U,0x3443U,0x0420U,0x1401U,0x64E6U,0x74C7U,0x44A4U,0x5485U,
+    0xA56AU,0xB54BU,0x8528U,0x9509U,0xE5EEU,0xF5CFU,0xC5ACU,0xD58DU,
+    0x3653U,0x2672U,0x1611U,0x0630U,0x76D7U,0x66F6U,0x5695U,0x46B4U,
+    0xB75BU,0xA77AU,0x9719U,0x8738U,0xF7DFU,0xE7FEU,0xD79DU,0xC7BCU,
+    0x48C4U,0x58E5U,0x6886U,0x78A7U,0x0840U,0x1861U,0x2802U,0x3823U,
+    0xC9CCU,0xD9EDU,0xE98EU,0xF9AFU,0x8948U,0x9969U,0xA90AU,0xB92BU,
+    0x5AF5U,0x4AD4U,0x7AB7U,0x6A96U,0x1A71U,0x0A50U,0x3A33U,0x2A12U,
+    0xDBFDU,0xCBDCU,0xFBBFU,0xEB9EU,0x9B79U,0x8B58U,0xBB3BU,0xAB1AU,
+    0x6CA6U,0x7C87U,0x4CE4U,0x5CC5U,0x2C22U,0x3C03U,0x0C60U,0x1C41U,
+    0xEDAEU,0xFD8FU,0xCDECU,0xDDCDU,0xAD2AU,0xBD0BU,0x8D68U,0x9D49U,
+    0x7E97U,0x6EB6U,0x5ED5U,0x4EF4U,0x3E13U,0x2E32U,0x1E51U,0x0E70U,
+    0xFF9FU,0xEFBEU,0xDFDDU,0xCFFCU,0xBF1BU,0xAF3AU,0x9F59U,0x8F78U,
+    0x9188U,0x81A9U,0xB1CAU,0xA1EBU,0xD10CU,0xC12DU,0xF14EU,0xE16FU,
+    0x1080U,0x00A1U,0x30C2U,0x20E3U,0x5004U,0x4025U,0x7046U,0x6067U,
+    0x83B9U,0x9398U,0xA3FBU,0xB3DAU,0xC33DU,0xD31CU,0xE37FU,0xF35EU,
+    0x02B1U,0x1290U,0x22F3U,0x32D2U,0x4235U,0x5214U,0x6277U,0x7256U,
+    0xB5EAU,0xA5CBU,0x95A8U,0x8589U,0xF56EU,0xE54FU,0xD52CU,0xC50DU,
+    0x34E2U,0x24C3U,0x14A0U,0x0481U,0x7466U,0x6447U,0x5424U,0x4405U,
+    0xA7DBU,0xB7FAU,0x8799U,0x97B8U,0xE75FU,0xF77EU,0xC71DU,0xD73CU,
+    0x26D3U,0x36F2U,0x0691U,0x16B0U,0x6657U,0x7676U,0x4615U,0x5634U,
+    0xD94CU,0xC96DU,0xF90EU,0xE92FU,0x99C8U,0x89E9U,0xB98AU,0xA9ABU,
+    0x5844U,0x4865U,0x7806U,0x6827U,0x18C0U,0x08E1U,0x3882U,0x28A3U,
+    0xCB7DU,0xDB5CU,0xEB3FU,0xFB1EU,0x8BF9U,0x9BD8U,0xABBBU,0xBB9AU,
+    0x4A75U,0x5A54U,0x6A37U,0x7A16U,0x0AF1U,0x1AD0U,0x2AB3U,0x3A92U,
+    0xFD2EU,0xED0FU,0xDD6CU,0xCD4DU,0xBDAAU,0xAD8BU,0x9DE8U,0x8DC9U,
+    0x7C26U,0x6C07U,0x5C64U,0x4C45U,0x3CA2U,0x2C83U,0x1CE0U,0x0CC1U,
+    0xEF1FU,0xFF3EU,0xCF5DU,0xDF7CU,0xAF9BU,0xBFBAU,0x8FD9U,0x9FF8U,
+    0x6E17U,0x7E36U,0x4E55U,0x5E74U,0x2E93U,0x3EB2U,0x0ED1U,0x1EF0U,
+};
+
+// slicing-by-8 tables, crc16_slice[k][b] is the CRC of byte b followed by k zero bytes
+// crc16_slice[0] equals crc16_table
+static uint16_t crc16_slice[8][256];
+static int crc16_ready = 0;
+
+// Every implementation is written once with an optional destination: with dst NULL it only computes the CRC,
+// otherwise each block is loaded once, stored to dst and folded into the CRC while it is in a register,
+// so copying a span into a packet buffer and checksumming it is a single pass over the memory.
+// The wrappers pass a constant dst, the compiler drops the stores of the CRC-only variants.
+
+static inline __attribute__((always_inline))
+uint16_t crc16_bytewise_run(uint16_t crc, uint8_t* dst, const uint8_t* data, size_t len)
+{
+    while (len > 0)
+    {
+        uint8_t b = *data;
+        if (dst != NULL)
+        {
+            *dst++ = b;
+        }
+        crc = crc16_table[b ^ (unsigned char)(crc >> 8)] ^ (crc << 8);
+        data++;
+        len--;
+    }
+    return crc;
+}
+
+static inline __attribute__((always_inline))
+uint16_t crc16_slice8_run(uint16_t crc, uint8_t* dst, const uint8_t* data, size_t len)
+{
+    while (len >= 8)
+    {
+        // one 64 bit load, the lookups work on the local copy
+        uint8_t b[8];
+        memcpy(b, data, 8);
+        if (dst != NULL)
+        {
+            memcpy(dst, b, 8);
+            dst += 8;
+        }
+        // the CRC state is folded into the first two bytes, all eight lookups are independent
+        crc ^= (uint16_t)(b[0] << 8 | b[1]);
+        crc = crc16_slice[7][crc >> 8] ^ crc16_slice[6][crc & 0xFF] ^
+              crc16_slice[5][b[2]] ^ crc16_slice[4][b[3]] ^
+              crc16_slice[3][b[4]] ^ crc16_slice[2][b[5]] ^
+              crc16_slice[1][b[6]] ^ crc16_slice[0][b[7]];
+        data += 8;
+        len -= 8;
+    }
+    return crc16_bytewise_run(crc, dst, data, len);
+}
+
+static uint16_t crc16_bytewise(uint16_t crc, const uint8_t* data, size_t len)
+{
+    return crc16_bytewise_run(crc, NULL, data, len);
+}
+
+static uint16_t crc16_copy_bytewise(uint16_t crc, uint8_t* dst, const uint8_t* src, size_t len)
+{
+    return crc16_bytewise_run(crc, dst, src, len);
+}
+
+static uint16_t crc16_slice8(uint16_t crc, const uint8_t* data, size_t len)
+{
+    return crc16_slice8_run(crc, NULL, data, len);
+}
+
+static uint16_t crc16_copy_slice8(uint16_t crc, uint8_t* dst, const uint8_t* src, size_t len)
+{
+    return crc16_slice8_run(crc, dst, src, len);
+}
+
+#ifdef CRC16_HAVE_PCLMUL
+// folding constants x^128 mod P and x^192 mod P
+static uint64_t crc16_fold128;
+static uint64_t crc16_fold192;
+
+// remainder of x^n divided by the CRC polynomial 0x11021
+static uint16_t crc16_xpow_mod(unsigned int n)
+{
+    uint32_t r = 1;
+    while (n-- > 0)
+    {
+        r <<= 1;
+        if (r & 0x10000)
+        {
+            r ^= 0x11021;
+        }
+    }
+    return (uint16_t)r;
+}
+
+// The message is loaded in 16 byte blocks as 128 bit polynomials (first byte = highest coefficients).
+// The accumulator x = H * x^64 + L is moved 128 bit further with H * (x^192 mod P) + L * (x^128 mod P),
+// both products are at most 79 bit long, and the next block is xored in. The remaining 128 bit and
+// the tail are reduced by the table implementation.
+static inline __attribute__((always_inline, target("pclmul,ssse3")))
+uint16_t crc16_pclmul_run(uint16_t crc, uint8_t* dst, const uint8_t* data, size_t len)
+{
+    if (len < 32)
+    {
+        return crc16_slice8_run(crc, dst, data, len);
+    }
+    const __m128i bswap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i k = _mm_set_epi64x((long long)crc16_fold192, (long long)crc16_fold128);
+    __m128i v = _mm_loadu_si128((const __m128i*)data);
+    if (dst != NULL)
+    {
+        _mm_storeu_si128((__m128i*)dst, v);
+        dst += 16;
+    }
+    __m128i x = _mm_shuffle_epi8(v, bswap);
+    // the CRC state is xored into the first two bytes of the message
+    x = _mm_xor_si128(x, _mm_slli_si128(_mm_cvtsi32_si128(crc), 14));
+    data += 16;
+    len -= 16;
+    while (len >= 16)
+    {
+        v = _mm_loadu_si128((const __m128i*)data);
+        if (dst != NULL)
+        {
+            _mm_storeu_si128((__m128i*)dst, v);
+            dst += 16;
+        }
+        __m128i b = _mm_shuffle_epi8(v, bswap);
+        __m128i hi = _mm_clmulepi64_si128(x, k, 0x11);
+        __m128i lo = _mm_clmulepi64_si128(x, k, 0x00);
+        x = _mm_xor_si128(_mm_xor_si128(hi, lo), b);
+        data += 16;
+        len -= 16;
+    }
+    uint8_t rest[16];
+    _mm_storeu_si128((__m128i*)rest, _mm_shuffle_epi8(x, bswap));
+    crc = crc16_slice8_run(0, NULL, rest, sizeof(rest));
+    return crc16_slice8_run(crc, dst, data, len);
+}
+
+__attribute__((target("pclmul,ssse3")))
+static uint16_t crc16_pclmul(uint16_t crc, const uint8_t* data, size_t len)
+{
+    return crc16_pclmul_run(crc, NULL, data, len);
+}
+
+__attribute__((target("pclmul,ssse3")))
+static uint16_t crc16_copy_pclmul(uint16_t crc, uint8_t* dst, const uint8_t* src, size_t len)
+{
+    return crc16_pclmul_run(crc, dst, src, len);
+}
+#endif
+
+static uint16_t crc16_dispatch(uint16_t crc, const uint8_t* data, size_t len);
+
+static uint16_t crc16_copy_dispatch(uint16_t crc, uint8_t* dst, const uint8_t* src, size_t len);
+
+static uint16_t (*crc16_impl)(uint16_t crc, const uint8_t* data, size_t len) = crc16_dispatch;
+static uint16_t (*crc16_copy_impl)(uint16_t crc, uint8_t* dst, const uint8_t* src, size_t len) = crc16_copy_dispatch;
+static const char* crc16_impl_name = "none";
+
+void ccsds_crc16_init(void)
+{
+    if (crc16_ready)
+    {
+        return;
+    }
+    for (int b = 0; b < 256; b++)
+    {
+        crc16_slice[0][b] = crc16_table[b];
+    }
+    for (int k = 1; k < 8; k++)
+    {
+        for (int b = 0; b < 256; b++)
+        {
+            uint16_t prev = crc16_slice[k - 1][b];
+            crc16_slice[k][b] = (prev << 8) ^ crc16_table[prev >> 8];
+        }
+    }
+#ifdef CRC16_HAVE_PCLMUL
+    crc16_fold128 = crc16_xpow_mod(128);
+    crc16_fold192 = crc16_xpow_mod(192);
+#endif
+    crc16_ready = 1;
+#if CCSDS_CRC16_IMPL == CCSDS_CRC16_AUTO
+    if (ccsds_crc16_select(CCSDS_CRC16_PCLMUL) != 0)
+    {
+        ccsds_crc16_select(CCSDS_CRC16_SLICE8);
+    }
+#else
+    // a fixed choice the target cannot run (e.g. PCLMUL on a CPU without PCLMULQDQ or on the board)
+    // must not leave the dispatcher in place, it would call itself
+    if (ccsds_crc16_select(CCSDS_CRC16_IMPL) != 0)
+    {
+        osal_printf("CRC16 implementation %d not supported, using slice8\n", CCSDS_CRC16_IMPL);
+        ccsds_crc16_select(CCSDS_CRC16_SLICE8);
+    }
+#endif
+}
+
+int ccsds_crc16_select(int impl)
+{
+    ccsds_crc16_init();
+    switch (impl)
+    {
+    case CCSDS_CRC16_BYTEWISE:
+        crc16_impl = crc16_bytewise;
+        crc16_copy_impl = crc16_copy_bytewise;
+        crc16_impl_name = "bytewise";
+        return 0;
+    case CCSDS_CRC16_SLICE8:
+        crc16_impl = crc16_slice8;
+        crc16_copy_impl = crc16_copy_slice8;
+        crc16_impl_name = "slice8";
+        return 0;
+#ifdef CRC16_HAVE_PCLMUL
+    case CCSDS_CRC16_PCLMUL:
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3"))
+        {
+            crc16_impl = crc16_pclmul;
+            crc16_copy_impl = crc16_copy_pclmul;
+            crc16_impl_name = "pclmul";
+            return 0;
+        }
+        return -1;
+#endif
+    default:
+        return -1;
+    }
+}
+
+const char* ccsds_crc16_name(void)
+{
+    ccsds_crc16_init();
+    return crc16_impl_name;
+}
+
+static uint16_t crc16_dispatch(uint16_t crc, const uint8_t* data, size_t len)
+{
+    ccsds_crc16_init();
+    return crc16_impl(crc, data, len);
+}
+
+uint16_t ccsds_crc16_update(uint16_t crc, const uint8_t* data, size_t len)
+{
+    return crc16_impl(crc, data, len);
+}
+
+static uint16_t crc16_copy_dispatch(uint16_t crc, uint8_t* dst, const uint8_t* src, size_t len)
+{
+    ccsds_crc16_init();
+    return crc16_copy_impl(crc, dst, src, len);
+}
+
+uint16_t ccsds_crc16_copy(uint16_t crc, uint8_t* dst, const uint8_t* src, size_t len)
+{
+    return crc16_copy_impl(crc, dst, src, len);
+}
+
+// CRC16-CCITT-False Checksum
+unsigned short crc16sum(const uint8_t *data, unsigned int len, unsigned short crc)
+{
+    return crc16_impl(crc, data, len);
+}
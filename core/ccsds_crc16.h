@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ */
+
+#ifndef CCSDS_CRC16_H
+#define CCSDS_CRC16_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CCSDS_CRC16_INIT        0xFFFF
+
+// available implementations
+#define CCSDS_CRC16_AUTO        0   // fastest one supported by the CPU, chosen at runtime
+#define CCSDS_CRC16_BYTEWISE    1   // one table lookup per byte
+#define CCSDS_CRC16_SLICE8      2   // slicing-by-8, eight table lookups per 8 bytes without dependency between them
+#define CCSDS_CRC16_PCLMUL      3   // carry-less multiply folding of 16 byte blocks (x86 with PCLMULQDQ and SSSE3)
+
+// compile time selection, e.g. -DCCSDS_CRC16_IMPL=CCSDS_CRC16_SLICE8 to skip the CPU feature detection
+// the implementation is still called through a function pointer, slice8 stands in if the choice is not supported
+#ifndef CCSDS_CRC16_IMPL
+#define CCSDS_CRC16_IMPL        CCSDS_CRC16_AUTO
+#endif
+
+// prepare the tables and pick the implementation, called implicitly by the first update
+void ccsds_crc16_init(void);
+
+// switch to an implementation at runtime (benchmarks, tests), returns -1 if it is not supported
+int ccsds_crc16_select(int impl);
+
+// name of the implementation in use
+const char* ccsds_crc16_name(void);
+
+// CRC16-CCITT-False Checksum (poly 0x1021, init 0xFFFF, no reflection, no final xor)
+// continue the CRC state crc over the next span of bytes, start with CCSDS_CRC16_INIT for a new packet
+// feeding a packet in several spans gives the same result as feeding it at once
+uint16_t ccsds_crc16_update(uint16_t crc, const uint8_t* data, size_t len);
+
+// copy len bytes from src to dst (not overlapping) and continue the CRC state crc over them in the same pass,
+// every block is read once, stored and folded while it is in a register
+uint16_t ccsds_crc16_copy(uint16_t crc, uint8_t* dst, const uint8_t* src, size_t len);
+
+// crc is the start value, pass 0xFFFF for a new packet or the result of a previous call to continue
+unsigned short crc16sum(const uint8_t *data, unsigned int len, unsigned short crc);
+
+#endif
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     persistent socket, batched sends and packet aggregation
+ * 2026-10-17   Nico Maas     per-APID routing to several destinations
+ */
+
+#include <string.h>
+
+#include "ccsds_forward.h"
+#include "ccsds_trace.h"
+#include "osal.h"
+
+int ccsds_forward_init(struct ccsds_forward* forward, struct ccsds_pool* pool, struct ccsds_metrics* metrics,
+                       struct ccsds_route_table* routes, uint32_t mtu, uint32_t flush_ms)
+{
+    if (routes == NULL)
+    {
+        return -1;
+    }
+    forward->sock = osal_udp_open(0);
+    if (forward->sock == NULL)
+    {
+        return -1;
+    }
+    forward->pool = pool;
+    // an aggregate has to fit into a pool buffer
+    forward->mtu = (mtu < ccsds_pool_max_size(pool)) ? mtu : ccsds_pool_max_size(pool);
+    forward->flush_us = flush_ms * 1000;
+    forward->routes = routes;
+    forward->routes_next = NULL;
+    memset(forward->dests, 0, sizeof(forward->dests));
+    forward->metrics = metrics;
+    return 0;
+}
+
+void ccsds_forward_set_routes(struct ccsds_forward* forward, struct ccsds_route_table* routes)
+{
+    struct ccsds_route_table* unused = __atomic_exchange_n(&forward->routes_next, routes, __ATOMIC_ACQ_REL);
+    // a table published before and not taken over yet was never used
+    if (unused != NULL)
+    {
+        ccsds_route_table_free(unused);
+    }
+}
+
+// send all datagrams of the batch of a destination and release their buffers
+static void forward_send(struct ccsds_forward* forward, unsigned int index)
+{
+    struct ccsds_forward_dest* dest = &forward->dests[index];
+    struct osal_datagram datagrams[CCSDS_FORWARD_BATCH];
+    unsigned int count = dest->batch_count;
+    if (count == 0)
+    {
+        return;
+    }
+    for (unsigned int i = 0; i < count; i++)
+    {
+        datagrams[i].data = dest->batch[i]->data;
+        datagrams[i].len = dest->batch[i]->length;
+    }
+    int sent = osal_udp_send_batch(forward->sock, &forward->routes->addr[index], datagrams, count);
+    forward->metrics->forwarded_datagrams += sent;
+    if ((unsigned int)sent != count)
+    {
+        forward->metrics->send_errors += count - sent;
+        CCSDS_TRACE_ERROR(CCSDS_TRACE_FORWARD_ERROR, count - sent, 0);
+    }
+    // an aggregate carries the arrival time of its oldest packet
+    uint64_t now_us = osal_time_us();
+    for (unsigned int i = 0; i < count; i++)
+    {
+        ccsds_histogram_add(&forward->metrics->latency, now_us - dest->batch[i]->timestamp);
+        ccsds_buffer_free(dest->batch[i]);
+    }
+    dest->batch_count = 0;
+}
+
+// append a datagram to the batch of a destination, sending the batch first if it is full
+static void forward_queue(struct ccsds_forward* forward, unsigned int index, struct ccsds_buffer* datagram)
+{
+    struct ccsds_forward_dest* dest = &forward->dests[index];
+    if (dest->batch_count == CCSDS_FORWARD_BATCH)
+    {
+        forward_send(forward, index);
+    }
+    dest->batch[dest->batch_count++] = datagram;
+}
+
+// the aggregate is complete, queue it behind the datagrams before it
+static void forward_close_aggregate(struct ccsds_forward* forward, unsigned int index)
+{
+    struct ccsds_forward_dest* dest = &forward->dests[index];
+    if (dest->aggregate != NULL)
+    {
+        forward_queue(forward, index, dest->aggregate);
+        dest->aggregate = NULL;
+    }
+}
+
+// queue one reference of the packet for one destination
+static void forward_dest_packet(struct ccsds_forward* forward, unsigned int index, struct ccsds_buffer* packet)
+{
+    struct ccsds_forward_dest* dest = &forward->dests[index];
+    // without aggregation or if the packet fills a datagram on its own, send it as is
+    if (packet->length > forward->mtu)
+    {
+        forward_close_aggregate(forward, index);
+        forward_queue(forward, index, packet);
+        return;
+    }
+    if (dest->aggregate != NULL && dest->aggregate->length + packet->length > forward->mtu)
+    {
+        forward_close_aggregate(forward, index);
+    }
+    if (dest->aggregate == NULL)
+    {
+        dest->aggregate = ccsds_pool_alloc(forward->pool, forward->mtu);
+        if (dest->aggregate == NULL)
+        {
+            // no buffer to aggregate into, the packet still goes out on its own
+            forward_queue(forward, index, packet);
+            return;
+        }
+        dest->aggregate->length = 0;
+        dest->aggregate->timestamp = packet->timestamp;
+        dest->deadline = osal_time_us() + forward->flush_us;
+    }
+    memcpy(&dest->aggregate->data[dest->aggregate->length], packet->data, packet->length);
+    dest->aggregate->length += packet->length;
+    ccsds_buffer_free(packet);
+}
+
+// Send the content via UDP to the IPs and ports the APID is routed to
+void ccsds_forward_packet(void* arg, struct ccsds_buffer* packet)
+{
+    struct ccsds_forward* forward = arg;
+    uint16_t apid = (packet->data[0] & 0x07) << 8 | packet->data[1];
+    uint16_t dests = ccsds_route_lookup(forward->routes, apid);
+    if (dests == 0)
+    {
+        forward->metrics->unrouted_packets++;
+        ccsds_buffer_free(packet);
+        return;
+    }
+    forward->metrics->forwarded_packets++;
+    while (dests != 0)
+    {
+        unsigned int index = __builtin_ctz(dests);
+        dests &= dests - 1;
+        // every destination but the last one takes a reference of its own
+        if (dests != 0)
+        {
+            ccsds_buffer_ref(packet);
+        }
+        forward_dest_packet(forward, index, packet);
+    }
+}
+
+// take over a routing table published by ccsds_forward_set_routes
+static void forward_adopt_routes(struct ccsds_forward* forward)
+{
+    struct ccsds_route_table* routes = __atomic_exchange_n(&forward->routes_next, NULL, __ATOMIC_ACQUIRE);
+    if (routes == NULL)
+    {
+        return;
+    }
+    // everything queued so far was routed with the old table and goes to its destinations
+    for (unsigned int i = 0; i < forward->routes->dest_count; i++)
+    {
+        forward_close_aggregate(forward, i);
+        forward_send(forward, i);
+    }
+    ccsds_route_table_free(forward->routes);
+    forward->routes = routes;
+    CCSDS_TRACE_INFO(CCSDS_TRACE_FORWARD_ROUTES, routes->dest_count, 0);
+}
+
+void ccsds_forward_flush(struct ccsds_forward* forward, uint64_t now_us)
+{
+    forward_adopt_routes(forward);
+    for (unsigned int i = 0; i < forward->routes->dest_count; i++)
+    {
+        struct ccsds_forward_dest* dest = &forward->dests[i];
+        if (dest->aggregate != NULL && now_us >= dest->deadline)
+        {
+            forward_close_aggregate(forward, i);
+        }
+        forward_send(forward, i);
+    }
+}
+
+int32_t ccsds_forward_timeout(const struct ccsds_forward* forward, uint64_t now_us)
+{
+    int32_t timeout = OSAL_WAIT_FOREVER;
+    for (unsigned int i = 0; i < forward->routes->dest_count; i++)
+    {
+        const struct ccsds_forward_dest* dest = &forward->dests[i];
+        if (dest->aggregate == NULL)
+        {
+            continue;
+        }
+        if (now_us >= dest->deadline)
+        {
+            return 0;
+        }
+        // round up, waking up early would only lead to another wait
+        int32_t dest_timeout = (int32_t)((dest->deadline - now_us + 999) / 1000);
+        if (timeout == OSAL_WAIT_FOREVER || dest_timeout < timeout)
+        {
+            timeout = dest_timeout;
+        }
+    }
+    return timeout;
+}
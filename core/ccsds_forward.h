@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     persistent socket, batched sends and packet aggregation
+ * 2026-10-17   Nico Maas     per-APID routing to several destinations
+ */
+
+#ifndef CCSDS_FORWARD_H
+#define CCSDS_FORWARD_H
+
+#include <stdint.h>
+
+#include "ccsds_metrics.h"
+#include "ccsds_pool.h"
+#include "ccsds_route.h"
+#include "osal.h"
+
+// datagrams collected before they are sent in one go
+#define CCSDS_FORWARD_BATCH     16
+
+// datagrams waiting for one destination
+struct ccsds_forward_dest
+{
+    struct ccsds_buffer* batch[CCSDS_FORWARD_BATCH];    // datagrams ready to be sent
+    unsigned int batch_count;
+    struct ccsds_buffer* aggregate; // datagram being filled
+    uint64_t deadline;              // when aggregate has to be sent at the latest
+};
+
+// forwards reassembled packets via UDP to the experiment operator computers
+// the routing table gives the destinations of every APID, a packet for several destinations is not copied,
+// every destination holds a reference to its buffer
+// packets are collected per destination and sent as one batch by ccsds_forward_flush, e.g. after each received chunk
+// with mtu set, small packets are packed back to back into datagrams of up to mtu bytes,
+// such a datagram is sent once it is full or flush_ms after its first packet
+struct ccsds_forward
+{
+    osal_udp_t sock;
+    struct ccsds_pool* pool;
+    uint32_t mtu;                   // 0 sends every packet as a datagram of its own
+    uint32_t flush_us;
+    struct ccsds_route_table* routes;       // table in use, only touched by the forwarding thread
+    struct ccsds_route_table* routes_next;  // table published by ccsds_forward_set_routes and not adopted yet
+    struct ccsds_forward_dest dests[CCSDS_ROUTE_MAX_DESTS];    // indexed like the destinations of routes
+    struct ccsds_metrics* metrics;  // counters of the thread forwarding the packets
+};
+
+// opens the socket once and takes over the routing table, 0 on success
+int ccsds_forward_init(struct ccsds_forward* forward, struct ccsds_pool* pool, struct ccsds_metrics* metrics,
+                       struct ccsds_route_table* routes, uint32_t mtu, uint32_t flush_ms);
+
+// replace the routing table at runtime, may be called from any thread while packets are forwarded
+// the forwarding thread takes the table over with its next ccsds_forward_flush: the datagrams routed with the
+// old table are sent first, then the old table is freed (without any lock, the table pointer is exchanged)
+void ccsds_forward_set_routes(struct ccsds_forward* forward, struct ccsds_route_table* routes);
+
+// ccsds_packet_cb compatible, arg is the struct ccsds_forward, takes over the packet buffer
+void ccsds_forward_packet(void* arg, struct ccsds_buffer* packet);
+
+// send the collected datagrams and the aggregate if its deadline has passed
+void ccsds_forward_flush(struct ccsds_forward* forward, uint64_t now_us);
+
+// ms until ccsds_forward_flush has to be called again, OSAL_WAIT_FOREVER if nothing waits
+int32_t ccsds_forward_timeout(const struct ccsds_forward* forward, uint64_t now_us);
+
+#endif
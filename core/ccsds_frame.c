@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ */
+
+#include <string.h>
+
+#include "ccsds_crc16.h"
+#include "ccsds_frame.h"
+#include "ccsds_trace.h"
+#include "osal.h"
+
+static const uint8_t frame_asm[CCSDS_FRAME_ASM_SIZE] =
+{
+    CCSDS_FRAME_ASM >> 24, (CCSDS_FRAME_ASM >> 16) & 0xFF, (CCSDS_FRAME_ASM >> 8) & 0xFF, CCSDS_FRAME_ASM & 0xFF
+};
+
+int ccsds_frame_init(struct ccsds_frame* frame, const struct ccsds_frame_config* config, struct ccsds_metrics* metrics)
+{
+    uint32_t overhead = CCSDS_FRAME_PRIMARY_HEADER_SIZE + (config->fecf ? CCSDS_FRAME_FECF_SIZE : 0);
+    if (config->length <= overhead || config->length > CCSDS_FRAME_MAX_SIZE)
+    {
+        return -1;
+    }
+    frame->config = *config;
+    memset(frame->vc, 0, sizeof(frame->vc));
+    memset(frame->vc_count, 0, sizeof(frame->vc_count));
+    frame->vc_seen = 0;
+    frame->asm_fill = 0;
+    frame->locked = 0;
+    frame->skipped = 0;
+    frame->fill = 0;
+    frame->metrics = metrics;
+    frame->rx_time_us = 0;
+    ccsds_crc16_init();
+    return 0;
+}
+
+void ccsds_frame_attach(struct ccsds_frame* frame, unsigned int vcid, struct ccsds_fsm* fsm)
+{
+    frame->vc[vcid % CCSDS_FRAME_VCS] = fsm;
+}
+
+// bytes in front of the next ASM are skipped, the first one after a frame means the sync is lost
+static void frame_unlock(struct ccsds_frame* frame, size_t skipped)
+{
+    if (frame->locked)
+    {
+        frame->locked = 0;
+        frame->metrics->frame_sync_losses++;
+    }
+    frame->skipped += skipped;
+}
+
+// match the ASM, which may be split over spans, returns the number of bytes consumed
+static size_t frame_hunt(struct ccsds_frame* frame, const uint8_t* data, size_t len)
+{
+    size_t pos = 0;
+    while (pos < len && frame->asm_fill < CCSDS_FRAME_ASM_SIZE)
+    {
+        if (data[pos] == frame_asm[frame->asm_fill])
+        {
+            frame->asm_fill++;
+            pos++;
+        }
+        // the ASM does not overlap with itself, the mismatching byte may start the next one
+        else if (frame->asm_fill != 0)
+        {
+            frame_unlock(frame, frame->asm_fill);
+            frame->asm_fill = 0;
+        }
+        // skip all bytes which cannot start the ASM in bulk
+        else
+        {
+            const uint8_t* next = memchr(&data[pos], frame_asm[0], len - pos);
+            size_t skip = (next != NULL) ? (size_t)(next - &data[pos]) : len - pos;
+            frame_unlock(frame, skip);
+            pos += skip;
+        }
+    }
+    if (frame->asm_fill == CCSDS_FRAME_ASM_SIZE && !frame->locked)
+    {
+        CCSDS_TRACE_ERROR(CCSDS_TRACE_FRAME_SYNC, frame->skipped, 0);
+        frame->locked = 1;
+        frame->skipped = 0;
+    }
+    return pos;
+}
+
+// an aligned state machine stands at a packet boundary
+static inline int frame_boundary(const struct ccsds_fsm* fsm)
+{
+    return fsm->aligned && fsm->mode == 0 && fsm->sync_bytes == 0;
+}
+
+// restart the state machine at the packet the First Header Pointer points to
+static void frame_align(struct ccsds_frame* frame, struct ccsds_fsm* fsm, unsigned int vcid, unsigned int fhp)
+{
+    ccsds_fsm_align(fsm);
+    frame->metrics->realigned++;
+    CCSDS_TRACE_ERROR(CCSDS_TRACE_FRAME_ALIGN, vcid, fhp);
+}
+
+// check a complete frame and feed its packet zone to the state machine of its virtual channel
+static void frame_process(struct ccsds_frame* frame, const uint8_t* f)
+{
+    uint32_t length = frame->config.length;
+    struct ccsds_metrics* metrics = frame->metrics;
+    // the next frame starts with an ASM again
+    frame->asm_fill = 0;
+    // a frame failing the FECF tells nothing, not even its virtual channel, the gap in the
+    // virtual channel frame count shows the loss once the next good frame arrives
+    if (frame->config.fecf)
+    {
+        uint16_t sent = f[length - 2] << 8 | f[length - 1];
+        uint16_t computed = ccsds_crc16_update(CCSDS_CRC16_INIT, f, length - CCSDS_FRAME_FECF_SIZE);
+        if (sent != computed)
+        {
+            metrics->frame_errors++;
+            CCSDS_TRACE_ERROR(CCSDS_TRACE_FRAME_FECF_ERROR, sent, computed);
+            return;
+        }
+    }
+    // primary header: version (2 bit), spacecraft id (10), virtual channel id (3), OCF flag (1),
+    // master and virtual channel frame count (8 each), data field status with First Header Pointer (11)
+    uint16_t id = f[0] << 8 | f[1];
+    unsigned int scid = (id >> 4) & 0x3FF;
+    unsigned int vcid = (id >> 1) & 0x07;
+    uint8_t count = f[3];
+    uint16_t status = f[4] << 8 | f[5];
+    unsigned int fhp = status & 0x7FF;
+    if ((id >> 14) != 0)
+    {
+        metrics->frame_errors++;
+        return;
+    }
+    struct ccsds_fsm* fsm = frame->vc[vcid];
+    // the synchronisation flag marks a data field which is no packet zone
+    if ((frame->config.scid >= 0 && scid != (unsigned int)frame->config.scid) || fsm == NULL || (status & 0x4000))
+    {
+        metrics->frames_filtered++;
+        return;
+    }
+    // continuity of the virtual channel, a lost frame took bytes of the current packet with it
+    if ((frame->vc_seen & (1 << vcid)) && count != frame->vc_count[vcid])
+    {
+        uint8_t lost = count - frame->vc_count[vcid];
+        metrics->frames_lost += lost;
+        CCSDS_TRACE_ERROR(CCSDS_TRACE_FRAME_GAP, vcid, lost);
+        ccsds_fsm_reset(fsm);
+    }
+    frame->vc_seen |= 1 << vcid;
+    frame->vc_count[vcid] = count + 1;
+    if (fhp == CCSDS_FRAME_FHP_IDLE)
+    {
+        metrics->frames_filtered++;
+        return;
+    }
+    uint32_t start = CCSDS_FRAME_PRIMARY_HEADER_SIZE + ((status & 0x8000) ? (f[CCSDS_FRAME_PRIMARY_HEADER_SIZE] & 0x3F) + 1 : 0);
+    uint32_t end = length - (frame->config.fecf ? CCSDS_FRAME_FECF_SIZE : 0) - ((id & 0x01) ? CCSDS_FRAME_OCF_SIZE : 0);
+    if (start >= end || (fhp != CCSDS_FRAME_FHP_NONE && start + fhp >= end))
+    {
+        // the packet zone of the virtual channel is interrupted
+        metrics->frame_errors++;
+        ccsds_fsm_reset(fsm);
+        return;
+    }
+    metrics->frames++;
+    const uint8_t* zone = &f[start];
+    uint32_t zone_len = end - start;
+    fsm->rx_time_us = frame->rx_time_us;
+    // expire before feeding, an expired partial packet has to drop the alignment instead of
+    // the state machine hunting through the packet zone
+    ccsds_fsm_poll(fsm, frame->rx_time_us);
+    if (fsm->aligned && fhp != CCSDS_FRAME_FHP_NONE)
+    {
+        // the packet in progress has to end right at the First Header Pointer,
+        // otherwise a corrupted length went unnoticed and the state machine starts over there
+        ccsds_fsm_feed(fsm, zone, fhp);
+        if (!frame_boundary(fsm))
+        {
+            frame_align(frame, fsm, vcid, fhp);
+        }
+        zone += fhp;
+        zone_len -= fhp;
+    }
+    else if (!fsm->aligned)
+    {
+        // the bytes in front of the First Header Pointer belong to a packet whose start was lost
+        if (fhp == CCSDS_FRAME_FHP_NONE)
+        {
+            return;
+        }
+        frame_align(frame, fsm, vcid, fhp);
+        zone += fhp;
+        zone_len -= fhp;
+    }
+    // a length error on the way drops the alignment, the rest of the zone is lost then
+    ccsds_fsm_feed(fsm, zone, zone_len);
+}
+
+void ccsds_frame_feed(struct ccsds_frame* frame, const uint8_t* data, size_t len)
+{
+    uint32_t length = frame->config.length;
+    size_t pos = 0;
+    while (pos < len)
+    {
+        if (frame->config.asm_sync && frame->asm_fill < CCSDS_FRAME_ASM_SIZE)
+        {
+            pos += frame_hunt(frame, &data[pos], len - pos);
+        }
+        // a whole frame in the span is checked in place
+        else if (frame->fill == 0 && len - pos >= length)
+        {
+            frame_process(frame, &data[pos]);
+            pos += length;
+        }
+        // a frame split over spans is collected in buffer first
+        else
+        {
+            size_t n = len - pos;
+            if (n > length - frame->fill)
+            {
+                n = length - frame->fill;
+            }
+            memcpy(&frame->buffer[frame->fill], &data[pos], n);
+            frame->fill += n;
+            pos += n;
+            if (frame->fill == length)
+            {
+                frame->fill = 0;
+                frame_process(frame, frame->buffer);
+            }
+        }
+    }
+}
+
+void ccsds_frame_end(struct ccsds_frame* frame)
+{
+    // without ASM the rest of a frame in the next datagram could not be told apart from a new frame
+    if (!frame->config.asm_sync && frame->fill != 0)
+    {
+        frame->metrics->frame_errors++;
+        frame->fill = 0;
+    }
+}
+
+int ccsds_frame_poll(struct ccsds_frame* frame, uint64_t now_us)
+{
+    int expired = 0;
+    for (unsigned int i = 0; i < CCSDS_FRAME_VCS; i++)
+    {
+        if (frame->vc[i] != NULL)
+        {
+            expired += ccsds_fsm_poll(frame->vc[i], now_us);
+        }
+    }
+    return expired;
+}
+
+int32_t ccsds_frame_timeout(const struct ccsds_frame* frame, uint64_t now_us)
+{
+    int32_t timeout = OSAL_WAIT_FOREVER;
+    for (unsigned int i = 0; i < CCSDS_FRAME_VCS; i++)
+    {
+        if (frame->vc[i] != NULL)
+        {
+            int32_t vc_timeout = ccsds_fsm_timeout(frame->vc[i], now_us);
+            if (vc_timeout != OSAL_WAIT_FOREVER && (timeout == OSAL_WAIT_FOREVER || vc_timeout < timeout))
+            {
+                timeout = vc_timeout;
+            }
+        }
+    }
+    return timeout;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ */
+
+#ifndef CCSDS_FRAME_H
+#define CCSDS_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ccsds_fsm.h"
+#include "ccsds_metrics.h"
+
+// TM Transfer Frames (CCSDS 132.0-B)
+#define CCSDS_FRAME_ASM                 0x1ACFFC1D  // attached sync marker in front of every frame
+#define CCSDS_FRAME_ASM_SIZE            4
+#define CCSDS_FRAME_PRIMARY_HEADER_SIZE 6
+#define CCSDS_FRAME_OCF_SIZE            4
+#define CCSDS_FRAME_FECF_SIZE           2
+#define CCSDS_FRAME_MAX_SIZE            2048
+#define CCSDS_FRAME_VCS                 8
+// First Header Pointer values without a packet start
+#define CCSDS_FRAME_FHP_NONE            0x7FF       // the packet zone only continues a packet
+#define CCSDS_FRAME_FHP_IDLE            0x7FE       // only idle data
+
+// layout of the frames of one physical channel
+struct ccsds_frame_config
+{
+    uint16_t length;        // frame length in bytes incl. headers and trailer, without the ASM
+    uint8_t asm_sync;       // every frame is preceded by the ASM (1) or every datagram holds whole frames (0)
+    uint8_t fecf;           // frames end with a Frame Error Control Field (CRC16, 1) or not (0)
+    int16_t scid;           // spacecraft id of accepted frames, -1 accepts all
+};
+
+// input stage in front of the reassembly for streams of TM Transfer Frames
+// frames are found by the ASM (bytes between frames are skipped) or by their fixed length and checked
+// with the FECF, the packet zone of every frame goes to the state machine of its virtual channel
+// a state machine is only fed while it is aligned to the packet boundaries: after a lost frame (virtual
+// channel frame count gap, failed FECF) its partial packet is dropped and it restarts at the offset given
+// by the First Header Pointer of the next frame, so there is no hunting for SYNCWORDS and no false lock
+struct ccsds_frame
+{
+    struct ccsds_frame_config config;
+    struct ccsds_fsm* vc[CCSDS_FRAME_VCS];      // state machine per virtual channel, NULL: frames are filtered
+    uint8_t vc_count[CCSDS_FRAME_VCS];          // expected virtual channel frame count of the next frame
+    uint8_t vc_seen;                            // bit per virtual channel a frame was received on
+    uint8_t asm_fill;                           // bytes of the ASM matched so far
+    uint8_t locked;                             // the ASM was found where the previous frame ended
+    uint32_t skipped;                           // bytes skipped while hunting for the ASM
+    uint32_t fill;                              // bytes of the current frame stored in buffer
+    struct ccsds_metrics* metrics;              // counters of the thread feeding the frames
+    uint64_t rx_time_us;                        // arrival time of the span being fed, set by the caller
+    uint8_t buffer[CCSDS_FRAME_MAX_SIZE];       // frame split over spans
+};
+
+// returns -1 if the frame length does not fit the headers, trailer and CCSDS_FRAME_MAX_SIZE
+int ccsds_frame_init(struct ccsds_frame* frame, const struct ccsds_frame_config* config, struct ccsds_metrics* metrics);
+
+// feed the packet zones of virtual channel vcid into fsm (initialised with ccsds_fsm_init)
+void ccsds_frame_attach(struct ccsds_frame* frame, unsigned int vcid, struct ccsds_fsm* fsm);
+
+// feed a span of received bytes, completed packets are passed to the packet_cb of the state machines
+// set rx_time_us to the arrival time of the span before
+void ccsds_frame_feed(struct ccsds_frame* frame, const uint8_t* data, size_t len);
+
+// end of a datagram, which may have been fed in several spans
+// without ASM a datagram holds whole frames, a partial frame is dropped so the next datagram starts a new one
+void ccsds_frame_end(struct ccsds_frame* frame);
+
+// ccsds_fsm_poll and ccsds_fsm_timeout over the state machines of all virtual channels
+int ccsds_frame_poll(struct ccsds_frame* frame, uint64_t now_us);
+int32_t ccsds_frame_timeout(const struct ccsds_frame* frame, uint64_t now_us);
+
+#endif
@@ -0,0 +1,486 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     configuration replaceable at packet boundaries
+ * 2026-10-17   Nico Maas     CRC folded in while copying
+ * 2026-10-17   Nico Maas     ccsds_fsm_deinit
+ * 2026-10-17   Nico Maas     packets carry the configuration they were reassembled under
+ * 2026-10-17   Nico Maas     timeouts beyond 71 minutes
+ */
+
+#include <string.h>
+
+#include "ccsds_apid.h"
+#include "ccsds_crc16.h"
+#include "ccsds_fsm.h"
+#include "ccsds_trace.h"
+#include "osal.h"
+
+// stands in for the configuration of APIDs which are not configured while aligned, their packets are skipped
+static const struct ccsds_apid_config fsm_foreign_apid = { 0x7FF, 0, 0, 0 };
+
+int ccsds_fsm_init(struct ccsds_fsm* fsm, const struct ccsds_apid_table* apids, struct ccsds_pool* pool,
+                   struct ccsds_metrics* metrics, ccsds_packet_cb packet_cb, void* packet_cb_arg)
+{
+    // a rejected candidate is never longer than the largest packet buffer
+    fsm->replay_size = ccsds_pool_max_size(pool);
+    fsm->replay = osal_malloc(fsm->replay_size);
+    if (fsm->replay == NULL)
+    {
+        return -1;
+    }
+    fsm->replay_len = 0;
+    fsm->replay_pos = 0;
+    fsm->rejected = 0;
+    fsm->pool = pool;
+    fsm->packet = NULL;
+    fsm->metrics = metrics;
+    fsm->rx_time_us = 0;
+    fsm->start_us = 0;
+    fsm->last_us = 0;
+    fsm->timeout_us = 0;
+    fsm->timeout_rescan = 0;
+    fsm->apids = apids;
+    fsm->apids_next = NULL;
+    fsm->apid = NULL;
+    fsm->packet_cb = packet_cb;
+    fsm->packet_cb_arg = packet_cb_arg;
+    fsm->packet_length = 0;
+    ccsds_crc16_init();
+    ccsds_fsm_reset(fsm);
+    return 0;
+}
+
+// drop the current packet and start hunting for the next SYNCWORD with two fresh bytes
+static void fsm_restart(struct ccsds_fsm* fsm)
+{
+    if (fsm->packet != NULL)
+    {
+        ccsds_buffer_free(fsm->packet);
+        fsm->packet = NULL;
+    }
+    fsm->mode = 0;
+    fsm->sync_bytes = 0;
+    fsm->syncword = 0;
+    fsm->fill = 0;
+    fsm->needed = 0;
+    fsm->apid = NULL;
+    // packet boundary, the next packet starts under a configuration set meanwhile
+    if (fsm->apids_next != NULL)
+    {
+        fsm->apids = fsm->apids_next;
+        fsm->apids_next = NULL;
+    }
+}
+
+void ccsds_fsm_deinit(struct ccsds_fsm* fsm)
+{
+    ccsds_fsm_reset(fsm);
+    osal_free(fsm->replay);
+    fsm->replay = NULL;
+}
+
+void ccsds_fsm_reset(struct ccsds_fsm* fsm)
+{
+    fsm_restart(fsm);
+    fsm->replay_len = 0;
+    fsm->replay_pos = 0;
+    fsm->rejected = 0;
+    fsm->aligned = 0;
+}
+
+void ccsds_fsm_set_apids(struct ccsds_fsm* fsm, const struct ccsds_apid_table* apids)
+{
+    fsm->apids_next = apids;
+    // nothing partial, take it at once
+    if (fsm->mode == 0 && fsm->sync_bytes == 0)
+    {
+        fsm->apids = apids;
+        fsm->apids_next = NULL;
+    }
+}
+
+void ccsds_fsm_align(struct ccsds_fsm* fsm)
+{
+    ccsds_fsm_reset(fsm);
+    fsm->aligned = 1;
+}
+
+// an aligned state machine does not know where the next packet starts anymore
+// the candidate is dropped without a rescan, the input stage aligns it again
+static void fsm_misalign(struct ccsds_fsm* fsm)
+{
+    fsm->rejected = 0;
+    fsm->aligned = 0;
+    fsm_restart(fsm);
+}
+
+// the current candidate turned out to be no packet (false SYNCWORD lock)
+// keep its bytes, ccsds_fsm_feed rescans them starting one byte after the false SYNCWORD
+static void fsm_reject(struct ccsds_fsm* fsm)
+{
+    fsm->rejected = 1;
+}
+
+// queue the bytes of the current candidate for a new SYNCWORD hunt, in front of
+// the replay bytes not consumed yet, then drop the candidate
+static void fsm_requeue(struct ccsds_fsm* fsm)
+{
+    const uint8_t* candidate = (fsm->fill <= CCSDS_PRIMARY_HEADER_SIZE) ? fsm->header : fsm->packet->data;
+    uint32_t count = fsm->fill - 1;
+    uint32_t remaining = fsm->replay_len - fsm->replay_pos;
+    memmove(&fsm->replay[count], &fsm->replay[fsm->replay_pos], remaining);
+    memcpy(fsm->replay, &candidate[1], count);
+    fsm->replay_pos = 0;
+    fsm->replay_len = count + remaining;
+    fsm->rejected = 0;
+    fsm->metrics->rescanned_bytes += count;
+    CCSDS_TRACE_DEBUG(CCSDS_TRACE_FSM_RESCAN, count, 0);
+    fsm_restart(fsm);
+}
+
+// the current candidate was rejected (false SYNCWORD lock)
+static void fsm_rescan(struct ccsds_fsm* fsm)
+{
+    fsm->metrics->false_locks++;
+    fsm_requeue(fsm);
+}
+
+// counters of the APID of the current candidate
+static inline struct ccsds_apid_metrics* fsm_apid_metrics(struct ccsds_fsm* fsm)
+{
+    return &fsm->metrics->apids[fsm->apid - fsm->apids->config];
+}
+
+// hand the completed packet over to the receiver and restart with mode 0
+static void fsm_deliver(struct ccsds_fsm* fsm)
+{
+    // the buffer belongs to the receiver from now on
+    struct ccsds_buffer* packet = fsm->packet;
+    packet->length = fsm->fill;
+    packet->timestamp = fsm->rx_time_us;
+    packet->apids = fsm->apids;
+    fsm->packet = NULL;
+    struct ccsds_apid_metrics* apid = fsm_apid_metrics(fsm);
+    apid->packets++;
+    apid->bytes += packet->length;
+    ccsds_histogram_add(&fsm->metrics->reassembly, fsm->rx_time_us - fsm->start_us);
+    CCSDS_TRACE_INFO(CCSDS_TRACE_FSM_PACKET, fsm->apid->apid, packet->length);
+    fsm->packet_cb(fsm->packet_cb_arg, packet);
+}
+
+// called whenever the bytes of the current mode are complete
+static void fsm_advance(struct ccsds_fsm* fsm)
+{
+    // mode 2, SYNCWORD was found and sequence flag and sequence count were read
+    if (fsm->mode == 2)
+    {
+        fsm->mode = 21;
+        fsm->needed = 2;
+        CCSDS_TRACE_DEBUG(CCSDS_TRACE_FSM_HEADER, fsm->header[2] >> 6, (fsm->header[2] & 0x3F) << 8 | fsm->header[3]);
+    }
+    // mode 21, data length field has been read
+    // calculate the length of the data portion without the CRC fields
+    // and take a buffer for the whole packet out of the pool
+    else if (fsm->mode == 21)
+    {
+        uint32_t data_length = (fsm->header[4] << 8 | fsm->header[5]) + 1;
+        // aligned to a packet of an APID which is not configured (e.g. idle packets), skip it
+        if (fsm->apid == &fsm_foreign_apid)
+        {
+            fsm->metrics->skipped_packets++;
+            fsm->mode = 24;
+            fsm->needed = data_length;
+            return;
+        }
+        uint32_t size = CCSDS_PRIMARY_HEADER_SIZE + data_length;
+        uint32_t crc_length = fsm->apid->crc ? 2 : 0;
+        uint32_t max_size = ccsds_pool_max_size(fsm->pool);
+        if (fsm->apid->max_length != 0 && fsm->apid->max_length < max_size)
+        {
+            max_size = fsm->apid->max_length;
+        }
+        // the data field has to hold at least the CRC and the whole packet has to fit into the
+        // configured maximum and the largest buffer, check before committing to the candidate
+        if (data_length < crc_length || size > max_size)
+        {
+            fsm_apid_metrics(fsm)->length_errors++;
+            CCSDS_TRACE_ERROR(CCSDS_TRACE_FSM_LENGTH_ERROR, data_length, max_size);
+            fsm_reject(fsm);
+            return;
+        }
+        fsm->packet_length = data_length - crc_length;
+        fsm->packet = ccsds_pool_alloc(fsm->pool, size);
+        if (fsm->packet == NULL)
+        {
+            // no buffer left, skip the packet to stay in sync with the stream
+            fsm_apid_metrics(fsm)->pool_exhausted++;
+            fsm->mode = 24;
+            fsm->needed = data_length;
+            CCSDS_TRACE_ERROR(CCSDS_TRACE_FSM_POOL_EXHAUSTED, fsm->apid->apid, size);
+            return;
+        }
+        memcpy(fsm->packet->data, fsm->header, CCSDS_PRIMARY_HEADER_SIZE);
+        fsm->mode = 22;
+        fsm->needed = fsm->packet_length;
+        CCSDS_TRACE_DEBUG(CCSDS_TRACE_FSM_LENGTH, size, 0);
+    }
+    // mode 22, payload data has been read
+    // packets of APIDs without CRC are complete now
+    else if (fsm->mode == 22)
+    {
+        if (fsm->apid->crc)
+        {
+            fsm->mode = 23;
+            fsm->needed = 2;
+            CCSDS_TRACE_DEBUG(CCSDS_TRACE_FSM_PAYLOAD, fsm->packet_length, 0);
+        }
+        else
+        {
+            // no chksum configured, sending data
+            fsm_deliver(fsm);
+            fsm_restart(fsm);
+        }
+    }
+    // mode 23, CRC fields have been read,
+    // compare the CRC computed while the packet arrived with the sent one
+    // if ok, hand the packet over for forwarding and restart with mode 0
+    // if not, rescan the packet for a SYNCWORD starting after its first byte
+    else if (fsm->mode == 23)
+    {
+        uint8_t* data = fsm->packet->data;
+        uint16_t sent = data[fsm->fill - 2] << 8 | data[fsm->fill - 1];
+        uint16_t chkSum = fsm->crc;
+        if (sent == chkSum)
+        {
+            fsm_deliver(fsm);
+            fsm_restart(fsm);
+        }
+        else
+        {
+            fsm_apid_metrics(fsm)->crc_errors++;
+            CCSDS_TRACE_ERROR(CCSDS_TRACE_FSM_CRC_ERROR, sent, chkSum);
+            // aligned, the length was right: drop the packet, the next one follows behind it
+            if (fsm->aligned)
+            {
+                fsm_restart(fsm);
+            }
+            else
+            {
+                fsm_reject(fsm);
+            }
+        }
+    }
+    // mode 24, a packet without buffer has been skipped
+    else if (fsm->mode == 24)
+    {
+        fsm_restart(fsm);
+    }
+}
+
+// run the state machine over a span until it is consumed or a candidate was rejected
+static size_t fsm_process(struct ccsds_fsm* fsm, const uint8_t* data, size_t len)
+{
+    size_t pos = 0;
+    while (pos < len && !fsm->rejected)
+    {
+        // aligned, the next byte starts a packet whatever its value is
+        if (fsm->mode == 0 && fsm->sync_bytes == 0 && fsm->aligned)
+        {
+            fsm->syncword = data[pos++];
+            fsm->sync_bytes = 1;
+        }
+        // try to find the start of the CCSDS TM packet (SYNCWORDS)
+        // with no candidate byte pending, skip all bytes which cannot start a SYNCWORD in bulk
+        else if (fsm->mode == 0 && fsm->sync_bytes == 0)
+        {
+            size_t skip = ccsds_apid_scan(fsm->apids, &data[pos], len - pos);
+            fsm->metrics->hunt_bytes += skip;
+            pos += skip;
+            if (pos < len)
+            {
+                fsm->syncword = data[pos++];
+                fsm->sync_bytes = 1;
+                fsm->metrics->hunt_bytes++;
+            }
+        }
+        // a candidate byte is pending, one bit test tells if it forms a SYNCWORD with the next byte
+        // if not, the next byte becomes the new candidate so every combination is tested
+        else if (fsm->mode == 0)
+        {
+            uint8_t next = data[pos++];
+            uint16_t word = (fsm->syncword << 8) | next;
+            fsm->apid = ccsds_apid_lookup(fsm->apids, word);
+            if (fsm->apid == NULL && fsm->aligned)
+            {
+                fsm->apid = &fsm_foreign_apid;
+            }
+            if (fsm->apid != NULL)
+            {
+                // yes, add to header, advance to mode 2
+                fsm->header[0] = word >> 8;
+                fsm->header[1] = word & 0xFF;
+                fsm->fill = 2;
+                fsm->crc = ccsds_crc16_update(CCSDS_CRC16_INIT, fsm->header, 2);
+                fsm->mode = 2;
+                fsm->needed = 2;
+                fsm->metrics->hunt_bytes -= !fsm->aligned;
+                fsm->start_us = fsm->rx_time_us;
+                CCSDS_TRACE_DEBUG(CCSDS_TRACE_FSM_LOCK, fsm->apid->apid, 0);
+            }
+            else
+            {
+                fsm->metrics->hunt_bytes++;
+                fsm->syncword = next;
+                fsm->sync_bytes = fsm->apids->first_byte[next];
+            }
+        }
+        // a packet without buffer is skipped at once
+        else if (fsm->mode == 24)
+        {
+            size_t n = len - pos;
+            if (n > fsm->needed)
+            {
+                n = fsm->needed;
+            }
+            fsm->needed -= n;
+            pos += n;
+            if (fsm->needed == 0)
+            {
+                fsm_advance(fsm);
+            }
+        }
+        // all other modes copy as many bytes as available and needed at once,
+        // the primary header into header, everything after it directly into the packet buffer
+        else
+        {
+            size_t n = len - pos;
+            if (n > fsm->needed)
+            {
+                n = fsm->needed;
+            }
+            uint8_t* dest = (fsm->fill < CCSDS_PRIMARY_HEADER_SIZE) ? &fsm->header[fsm->fill] : &fsm->packet->data[fsm->fill];
+            // everything up to the CRC field is covered by the CRC, it is folded in while the bytes are copied,
+            // so the check in mode 23 is a single compare and no byte of the packet is read twice
+            if (fsm->mode != 23 && fsm->apid->crc)
+            {
+                fsm->crc = ccsds_crc16_copy(fsm->crc, dest, &data[pos], n);
+            }
+            else
+            {
+                memcpy(dest, &data[pos], n);
+            }
+            fsm->fill += n;
+            fsm->needed -= n;
+            pos += n;
+            if (fsm->needed == 0)
+            {
+                fsm_advance(fsm);
+            }
+        }
+    }
+    return pos;
+}
+
+// run the bytes of rejected candidates through the state machine
+static void fsm_replay(struct ccsds_fsm* fsm)
+{
+    while (fsm->replay_pos < fsm->replay_len)
+    {
+        fsm->replay_pos += fsm_process(fsm, &fsm->replay[fsm->replay_pos], fsm->replay_len - fsm->replay_pos);
+        if (fsm->rejected)
+        {
+            fsm_rescan(fsm);
+        }
+    }
+}
+
+// a packet or a pending SYNCWORD candidate waits for more bytes
+static inline int fsm_partial(const struct ccsds_fsm* fsm)
+{
+    return fsm->mode != 0 || fsm->sync_bytes != 0;
+}
+
+// the partial packet got no new bytes in time, nothing arriving later belongs to it
+static void fsm_expire(struct ccsds_fsm* fsm)
+{
+    fsm->metrics->expired++;
+    CCSDS_TRACE_ERROR(CCSDS_TRACE_FSM_EXPIRED, fsm->mode, fsm->fill);
+    // a false lock with a large length may have swallowed complete packets, search its bytes once more
+    // (a skipped packet, mode 24, has no bytes stored, an aligned one is no false lock)
+    // the rescan may lock onto another false candidate which no later byte completes either, search on behind
+    // its first byte until no candidate is left, every round drops at least one byte
+    while (fsm->timeout_rescan && !fsm->aligned && fsm->mode != 0 && fsm->mode != 24)
+    {
+        fsm_requeue(fsm);
+        fsm_replay(fsm);
+    }
+    // whatever is still incomplete now cannot be completed anymore,
+    // and the rest of the lost packet must not be taken for the start of the next one
+    fsm_restart(fsm);
+    fsm->aligned = 0;
+}
+
+void ccsds_fsm_set_timeout(struct ccsds_fsm* fsm, uint32_t timeout_ms, uint8_t rescan)
+{
+    // any uint32_t ms fits in 64 bit us, a 32 bit product wraps after 71 minutes
+    fsm->timeout_us = (uint64_t)timeout_ms * 1000;
+    fsm->timeout_rescan = rescan;
+}
+
+int ccsds_fsm_poll(struct ccsds_fsm* fsm, uint64_t now_us)
+{
+    if (fsm->timeout_us == 0 || !fsm_partial(fsm) || now_us < fsm->last_us + fsm->timeout_us)
+    {
+        return 0;
+    }
+    fsm_expire(fsm);
+    return 1;
+}
+
+int32_t ccsds_fsm_timeout(const struct ccsds_fsm* fsm, uint64_t now_us)
+{
+    if (fsm->timeout_us == 0 || !fsm_partial(fsm))
+    {
+        return OSAL_WAIT_FOREVER;
+    }
+    uint64_t deadline = fsm->last_us + fsm->timeout_us;
+    if (now_us >= deadline)
+    {
+        return 0;
+    }
+    // round up, waking up early would only lead to another wait
+    uint64_t wait_ms = (deadline - now_us + 999) / 1000;
+    return (wait_ms > INT32_MAX) ? INT32_MAX : (int32_t)wait_ms;
+}
+
+size_t ccsds_fsm_feed(struct ccsds_fsm* fsm, const uint8_t* data, size_t len)
+{
+    // one deadline check per span instead of a timed wait per byte
+    ccsds_fsm_poll(fsm, fsm->rx_time_us);
+    size_t pos = 0;
+    while (1)
+    {
+        // bytes of rejected candidates go first, they precede the new span in the stream
+        fsm_replay(fsm);
+        if (pos >= len)
+        {
+            break;
+        }
+        pos += fsm_process(fsm, &data[pos], len - pos);
+        if (fsm->rejected && fsm->aligned)
+        {
+            fsm_misalign(fsm);
+            break;
+        }
+        if (fsm->rejected)
+        {
+            fsm_rescan(fsm);
+        }
+    }
+    fsm->last_us = fsm->rx_time_us;
+    return pos;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     configuration replaceable at packet boundaries
+ * 2026-10-17   Nico Maas     ccsds_fsm_deinit
+ * 2026-10-17   Nico Maas     packets carry the configuration they were reassembled under
+ * 2026-10-17   Nico Maas     timeouts beyond 71 minutes
+ */
+
+#ifndef CCSDS_FSM_H
+#define CCSDS_FSM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ccsds_apid.h"
+#include "ccsds_metrics.h"
+#include "ccsds_pool.h"
+
+// called for every reassembled packet with a correct CRC
+// the receiver owns the buffer and has to release it with ccsds_buffer_free
+typedef void (*ccsds_packet_cb)(void* arg, struct ccsds_buffer* packet);
+
+// reassembly engine
+// consumes spans of received bytes and advances through header, payload and CRC in bulk
+// modes: 0 hunt for a SYNCWORD, 2 sequence flag/count, 21 data length, 22 payload, 23 CRC,
+//        24 skip a packet no buffer was available for
+// packets of any length up to CCSDS_MAX_PACKET_SIZE are stored in buffers of the pool
+// if the length or CRC check fails, the SYNCWORD was a false lock: the bytes of the candidate are kept and
+// the hunt for the next SYNCWORD restarts one byte after the false one, so no real packet inside is lost
+// if an input stage knows the packet boundaries (TM Transfer Frames), the state machine is aligned instead:
+// the next byte always starts a packet, packets of other APIDs are skipped by their length and
+// nothing is hunted or rescanned, a length error or a lost packet drops the alignment
+struct ccsds_fsm
+{
+    uint8_t mode;                               // current mode of the state machine
+    uint8_t sync_bytes;                         // 1 if syncword holds a candidate first byte while in mode 0
+    uint16_t syncword;                          // candidate first byte of a SYNCWORD
+    uint32_t packet_length;                     // payload bytes of the current packet, without the CRC
+    uint32_t needed;                            // bytes still missing to complete the current mode
+    uint32_t fill;                              // bytes of the current packet stored in header and packet
+    uint16_t crc;                               // running CRC over the bytes of the current packet before the CRC field
+    const struct ccsds_apid_table* apids;       // SYNCWORD lookup generated out of the configuration
+    const struct ccsds_apid_table* apids_next;  // lookup set by ccsds_fsm_set_apids, taken at the next packet boundary
+    const struct ccsds_apid_config* apid;       // configuration of the APID of the current packet
+    ccsds_packet_cb packet_cb;
+    void* packet_cb_arg;
+    struct ccsds_pool* pool;
+    struct ccsds_buffer* packet;                // current packet, taken from the pool once its length is known
+    struct ccsds_metrics* metrics;              // counters of the thread feeding this state machine
+    uint64_t rx_time_us;                        // arrival time of the span being fed, set by the caller
+    uint64_t start_us;                          // arrival time of the first byte of the current packet
+    uint64_t last_us;                           // arrival time of the last span fed
+    uint64_t timeout_us;                        // inactivity timeout of a partial packet, 0: none
+    uint8_t timeout_rescan;                     // rescan an expired partial packet (1) or discard it (0)
+    uint8_t rejected;                           // current candidate was rejected, its bytes have to be rescanned
+    uint8_t aligned;                            // the next packet starts right after the current one (ccsds_fsm_align)
+    uint8_t* replay;                            // bytes of rejected candidates waiting for the next SYNCWORD hunt
+    uint32_t replay_size;
+    uint32_t replay_len;
+    uint32_t replay_pos;
+    uint8_t header[CCSDS_PRIMARY_HEADER_SIZE];  // primary header of the current packet
+};
+
+// allocates the rescan buffer (size of the largest pool buffer), returns -1 if that fails
+// metrics needs the per-APID counters of the APID configuration of apids
+int ccsds_fsm_init(struct ccsds_fsm* fsm, const struct ccsds_apid_table* apids, struct ccsds_pool* pool,
+                   struct ccsds_metrics* metrics, ccsds_packet_cb packet_cb, void* packet_cb_arg);
+
+// drop the current packet and release the rescan buffer, ccsds_fsm_init has to be called before the next use
+void ccsds_fsm_deinit(struct ccsds_fsm* fsm);
+
+// drop the current packet and all bytes waiting for a rescan and start hunting for the next SYNCWORD
+void ccsds_fsm_reset(struct ccsds_fsm* fsm);
+
+// hunt with another SYNCWORD lookup (e.g. a configuration loaded at runtime), only from the thread feeding fsm
+// a partial packet finishes under the lookup it started with, the new one is taken at the next packet boundary
+// every packet delivered carries the lookup it was checked with (ccsds_buffer apids)
+// the metrics have to be sized for the slots of both
+void ccsds_fsm_set_apids(struct ccsds_fsm* fsm, const struct ccsds_apid_table* apids);
+
+// 1 while a lookup set with ccsds_fsm_set_apids waits for the current packet to finish
+static inline int ccsds_fsm_switching(const struct ccsds_fsm* fsm)
+{
+    return fsm->apids_next != NULL;
+}
+
+// drop the current packet like ccsds_fsm_reset, the next byte fed starts a packet and so does every byte after
+// the end of a packet, until a length error or the inactivity timeout clears aligned again
+void ccsds_fsm_align(struct ccsds_fsm* fsm);
+
+// a partial packet which got no new bytes for timeout_ms (e.g. the downlink dropped in the middle of it) expires:
+// it is rescanned (rescan 1, packets inside a false lock are still delivered) or discarded (rescan 0)
+// and the state machine hunts for the next SYNCWORD, so the next pass is not glued onto it
+// the deadline is checked once per span by ccsds_fsm_feed and by ccsds_fsm_poll, timeout_ms 0 disables it
+void ccsds_fsm_set_timeout(struct ccsds_fsm* fsm, uint32_t timeout_ms, uint8_t rescan);
+
+// expire the partial packet if its deadline has passed, returns 1 if it expired
+int ccsds_fsm_poll(struct ccsds_fsm* fsm, uint64_t now_us);
+
+// ms until ccsds_fsm_poll has to be called, OSAL_WAIT_FOREVER if no partial packet is pending
+int32_t ccsds_fsm_timeout(const struct ccsds_fsm* fsm, uint64_t now_us);
+
+// feed a span of received bytes into the state machine
+// a span may hold several packets or parts of them, completed packets are passed to packet_cb
+// set rx_time_us to the arrival time of the span before, packets are stamped with it
+// returns the number of bytes consumed, less than len only if an aligned state machine lost the alignment
+size_t ccsds_fsm_feed(struct ccsds_fsm* fsm, const uint8_t* data, size_t len);
+
+#endif
@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     receive errors
+ * 2026-10-17   Nico Maas     stats datagram limited in size
+ * 2026-10-17   Nico Maas     sequence counters per APID
+ * 2026-10-17   Nico Maas     sequence counters printed and published
+ * 2026-10-17   Nico Maas     stats publisher frees what it got if it cannot start
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ccsds_conf.h"
+#include "ccsds_metrics.h"
+#include "osal.h"
+
+static struct ccsds_metrics* metrics_registered;
+
+int ccsds_metrics_init(struct ccsds_metrics* metrics, const char* name, unsigned int apid_count)
+{
+    memset(metrics, 0, sizeof(*metrics));
+    metrics->name = name;
+    metrics->apid_count = apid_count;
+    if (apid_count > 0)
+    {
+        // the per-APID counters get cache lines of their own as well
+        size_t size = apid_count * sizeof(struct ccsds_apid_metrics);
+        uint8_t* raw = osal_malloc(size + CCSDS_CACHE_LINE);
+        if (raw == NULL)
+        {
+            return -1;
+        }
+        uintptr_t aligned = ((uintptr_t)raw + CCSDS_CACHE_LINE - 1) & ~(uintptr_t)(CCSDS_CACHE_LINE - 1);
+        metrics->apids = (struct ccsds_apid_metrics*)aligned;
+        memset(metrics->apids, 0, size);
+    }
+    return 0;
+}
+
+void ccsds_metrics_register(struct ccsds_metrics* metrics)
+{
+    metrics->next = __atomic_load_n(&metrics_registered, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&metrics_registered, &metrics->next, metrics, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+static void histogram_sum(struct ccsds_histogram* total, const struct ccsds_histogram* histogram)
+{
+    for (unsigned int i = 0; i < CCSDS_HISTOGRAM_BUCKETS; i++)
+    {
+        total->buckets[i] += histogram->buckets[i];
+    }
+    total->count += histogram->count;
+    total->sum_us += histogram->sum_us;
+    if (histogram->max_us > total->max_us)
+    {
+        total->max_us = histogram->max_us;
+    }
+}
+
+void ccsds_metrics_sum(struct ccsds_metrics* total)
+{
+    struct ccsds_apid_metrics* apids = total->apids;
+    unsigned int apid_count = total->apid_count;
+    const char* name = total->name;
+    memset(total, 0, sizeof(*total));
+    memset(apids, 0, apid_count * sizeof(*apids));
+    total->apids = apids;
+    total->apid_count = apid_count;
+    total->name = name;
+    for (const struct ccsds_metrics* m = __atomic_load_n(&metrics_registered, __ATOMIC_ACQUIRE); m != NULL; m = m->next)
+    {
+        total->datagrams += m->datagrams;
+        total->queue_drops += m->queue_drops;
+        total->rx_errors += m->rx_errors;
+        total->rx_bytes += m->rx_bytes;
+        total->frames += m->frames;
+        total->frame_errors += m->frame_errors;
+        total->frames_filtered += m->frames_filtered;
+        total->frames_lost += m->frames_lost;
+        total->frame_sync_losses += m->frame_sync_losses;
+        total->realigned += m->realigned;
+        total->hunt_bytes += m->hunt_bytes;
+        total->false_locks += m->false_locks;
+        total->rescanned_bytes += m->rescanned_bytes;
+        total->expired += m->expired;
+        total->skipped_packets += m->skipped_packets;
+        total->egress_drops += m->egress_drops;
+        total->forwarded_packets += m->forwarded_packets;
+        total->forwarded_datagrams += m->forwarded_datagrams;
+        total->send_errors += m->send_errors;
+        total->unrouted_packets += m->unrouted_packets;
+        histogram_sum(&total->reassembly, &m->reassembly);
+        histogram_sum(&total->latency, &m->latency);
+        for (unsigned int i = 0; i < m->apid_count && i < apid_count; i++)
+        {
+            apids[i].packets += m->apids[i].packets;
+            apids[i].crc_errors += m->apids[i].crc_errors;
+            apids[i].length_errors += m->apids[i].length_errors;
+            apids[i].pool_exhausted += m->apids[i].pool_exhausted;
+            apids[i].gaps += m->apids[i].gaps;
+            apids[i].lost += m->apids[i].lost;
+            apids[i].duplicates += m->apids[i].duplicates;
+            apids[i].segment_errors += m->apids[i].segment_errors;
+            apids[i].bytes += m->apids[i].bytes;
+        }
+    }
+}
+
+uint32_t ccsds_histogram_percentile(const struct ccsds_histogram* histogram, unsigned int per_mille)
+{
+    if (histogram->count == 0)
+    {
+        return 0;
+    }
+    uint64_t rank = ((uint64_t)histogram->count * per_mille + 999) / 1000;
+    uint64_t seen = 0;
+    for (unsigned int i = 0; i < CCSDS_HISTOGRAM_BUCKETS - 1; i++)
+    {
+        seen += histogram->buckets[i];
+        if (seen >= rank)
+        {
+            // upper bound of the bucket, but never above the largest value seen
+            uint32_t bound = (i == 0) ? 0 : (1u << i) - 1;
+            return (bound < histogram->max_us) ? bound : histogram->max_us;
+        }
+    }
+    return histogram->max_us;
+}
+
+// the console of the board cannot print 64 bit values, so lines are formatted with the C library first
+static void metrics_line(const char* fmt, ...)
+{
+    char line[160];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    osal_printf("%s\n", line);
+}
+
+static void histogram_print(const char* name, const struct ccsds_histogram* histogram)
+{
+    metrics_line("%-10s count %lu, mean %lu us, p50 %lu us, p99 %lu us, p99.9 %lu us, max %lu us", name,
+                 (unsigned long)histogram->count,
+                 (unsigned long)(histogram->count ? histogram->sum_us / histogram->count : 0),
+                 (unsigned long)ccsds_histogram_percentile(histogram, 500),
+                 (unsigned long)ccsds_histogram_percentile(histogram, 990),
+                 (unsigned long)ccsds_histogram_percentile(histogram, 999),
+                 (unsigned long)histogram->max_us);
+}
+
+void ccsds_metrics_print(const struct ccsds_metrics* total, const struct ccsds_apid_table* apids)
+{
+    metrics_line("received:  %lu datagrams, %llu bytes, %lu dropped (incoming ring full), %lu receive errors",
+                 (unsigned long)total->datagrams, (unsigned long long)total->rx_bytes, (unsigned long)total->queue_drops,
+                 (unsigned long)total->rx_errors);
+    if (total->frames != 0 || total->frame_errors != 0)
+    {
+        metrics_line("frames:    %lu accepted, %lu errors, %lu filtered, %lu lost, %lu ASM losses, %lu realigned",
+                     (unsigned long)total->frames, (unsigned long)total->frame_errors, (unsigned long)total->frames_filtered,
+                     (unsigned long)total->frames_lost, (unsigned long)total->frame_sync_losses, (unsigned long)total->realigned);
+    }
+    metrics_line("hunting:   %llu bytes, %lu false locks, %llu bytes rescanned, %lu partial packets expired, %lu skipped",
+                 (unsigned long long)total->hunt_bytes, (unsigned long)total->false_locks, (unsigned long long)total->rescanned_bytes,
+                 (unsigned long)total->expired, (unsigned long)total->skipped_packets);
+    metrics_line("forwarded: %lu packets in %lu datagrams, %lu send errors, %lu dropped (egress queue full), %lu unrouted",
+                 (unsigned long)total->forwarded_packets, (unsigned long)total->forwarded_datagrams, (unsigned long)total->send_errors,
+                 (unsigned long)total->egress_drops, (unsigned long)total->unrouted_packets);
+    metrics_line("apid   packets        bytes  crc_err  len_err  no_buf     gaps      lost     dups  seg_err");
+    for (unsigned int i = 0; i < total->apid_count && i < apids->count; i++)
+    {
+        const struct ccsds_apid_config* config = &apids->config[i];
+        const struct ccsds_apid_metrics* apid = &total->apids[i];
+        if (config->apid == CCSDS_APID_UNUSED)
+        {
+            continue;
+        }
+        metrics_line("%4u %9lu %12llu %8lu %8lu %7lu %8lu %9lu %8lu %8lu", config->apid, (unsigned long)apid->packets,
+                     (unsigned long long)apid->bytes, (unsigned long)apid->crc_errors,
+                     (unsigned long)apid->length_errors, (unsigned long)apid->pool_exhausted, (unsigned long)apid->gaps,
+                     (unsigned long)apid->lost, (unsigned long)apid->duplicates, (unsigned long)apid->segment_errors);
+    }
+    histogram_print("reassembly", &total->reassembly);
+    histogram_print("latency", &total->latency);
+}
+
+// appends to a fixed buffer, remembers if anything did not fit
+struct json_writer
+{
+    char* buffer;
+    size_t size;
+    size_t pos;
+    int overflow;
+};
+
+static void json_append(struct json_writer* writer, const char* fmt, ...)
+{
+    if (writer->overflow)
+    {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(&writer->buffer[writer->pos], writer->size - writer->pos, fmt, args);
+    va_end(args);
+    if (n < 0 || (size_t)n >= writer->size - writer->pos)
+    {
+        writer->overflow = 1;
+        return;
+    }
+    writer->pos += n;
+}
+
+static void histogram_json(struct json_writer* writer, const char* name, const struct ccsds_histogram* histogram)
+{
+    json_append(writer, ",\"%s\":{\"count\":%lu,\"sum\":%llu,\"max\":%lu,\"buckets\":[", name,
+                (unsigned long)histogram->count, (unsigned long long)histogram->sum_us, (unsigned long)histogram->max_us);
+    for (unsigned int i = 0; i < CCSDS_HISTOGRAM_BUCKETS; i++)
+    {
+        json_append(writer, (i == 0) ? "%lu" : ",%lu", (unsigned long)histogram->buckets[i]);
+    }
+    json_append(writer, "]}");
+}
+
+size_t ccsds_metrics_json(const struct ccsds_metrics* total, const struct ccsds_apid_table* apids, char* buffer, size_t size)
+{
+    struct json_writer writer = { buffer, size, 0, 0 };
+    json_append(&writer, "{\"time_us\":%llu,\"datagrams\":%lu,\"rx_bytes\":%llu,\"queue_drops\":%lu,\"rx_errors\":%lu,"
+                "\"frames\":%lu,\"frame_errors\":%lu,\"frames_filtered\":%lu,\"frames_lost\":%lu,\"frame_sync_losses\":%lu,\"realigned\":%lu,"
+                "\"hunt_bytes\":%llu,\"false_locks\":%lu,\"rescanned_bytes\":%llu,\"expired\":%lu,\"skipped_packets\":%lu,"
+                "\"egress_drops\":%lu,\"forwarded_packets\":%lu,\"forwarded_datagrams\":%lu,\"send_errors\":%lu,\"unrouted_packets\":%lu,\"apids\":[",
+                (unsigned long long)osal_time_us(), (unsigned long)total->datagrams, (unsigned long long)total->rx_bytes,
+                (unsigned long)total->queue_drops, (unsigned long)total->rx_errors, (unsigned long)total->frames, (unsigned long)total->frame_errors,
+                (unsigned long)total->frames_filtered, (unsigned long)total->frames_lost, (unsigned long)total->frame_sync_losses,
+                (unsigned long)total->realigned, (unsigned long long)total->hunt_bytes, (unsigned long)total->false_locks,
+                (unsigned long long)total->rescanned_bytes, (unsigned long)total->expired, (unsigned long)total->skipped_packets,
+                (unsigned long)total->egress_drops, (unsigned long)total->forwarded_packets,
+                (unsigned long)total->forwarded_datagrams, (unsigned long)total->send_errors, (unsigned long)total->unrouted_packets);
+    // the APIDs may fill the buffer up to the room the histograms need
+    const size_t tail = 128 + 2 * (96 + CCSDS_HISTOGRAM_BUCKETS * 11);
+    writer.size = (size > tail) ? size - tail : 0;
+    unsigned int omitted = 0;
+    const char* separator = "";
+    for (unsigned int i = 0; i < total->apid_count && i < apids->count; i++)
+    {
+        const struct ccsds_apid_config* config = &apids->config[i];
+        const struct ccsds_apid_metrics* apid = &total->apids[i];
+        if (config->apid == CCSDS_APID_UNUSED ||
+            (apid->packets == 0 && apid->crc_errors == 0 && apid->length_errors == 0 && apid->pool_exhausted == 0 &&
+             apid->gaps == 0 && apid->duplicates == 0 && apid->segment_errors == 0))
+        {
+            continue;
+        }
+        size_t pos = writer.pos;
+        json_append(&writer, "%s{\"apid\":%u,\"packets\":%lu,\"bytes\":%llu,\"crc_errors\":%lu,\"length_errors\":%lu,\"pool_exhausted\":%lu,"
+                    "\"gaps\":%lu,\"lost\":%lu,\"duplicates\":%lu,\"segment_errors\":%lu}",
+                    separator, config->apid, (unsigned long)apid->packets, (unsigned long long)apid->bytes,
+                    (unsigned long)apid->crc_errors, (unsigned long)apid->length_errors, (unsigned long)apid->pool_exhausted,
+                    (unsigned long)apid->gaps, (unsigned long)apid->lost, (unsigned long)apid->duplicates,
+                    (unsigned long)apid->segment_errors);
+        if (writer.overflow)
+        {
+            writer.pos = pos;
+            writer.overflow = 0;
+            omitted++;
+            continue;
+        }
+        separator = ",";
+    }
+    writer.size = size;
+    json_append(&writer, "],\"apids_omitted\":%u", omitted);
+    histogram_json(&writer, "reassembly_us", &total->reassembly);
+    histogram_json(&writer, "latency_us", &total->latency);
+    json_append(&writer, "}");
+    return writer.overflow ? 0 : writer.pos;
+}
+
+void ccsds_metrics_thread(void* parameter)
+{
+    const struct ccsds_metrics_publisher* publisher = parameter;
+    // one publisher, the block (with its cache line alignment) stays off the thread stack
+    static struct ccsds_metrics total;
+    struct osal_addr dest;
+    // header, histograms and about 200 bytes per APID, at most one datagram of CCSDS_METRICS_JSON_SIZE
+    size_t size = 1536 + CCSDS_APID_SLOTS * 240;
+    size = (size < CCSDS_METRICS_JSON_SIZE) ? size : CCSDS_METRICS_JSON_SIZE;
+    char* buffer = osal_malloc(size);
+    osal_udp_t sock = osal_udp_open(0);
+    if (buffer == NULL || sock == NULL || osal_udp_resolve(publisher->dest_ip, publisher->dest_port, &dest) != 0
+        || ccsds_metrics_init(&total, "total", CCSDS_APID_SLOTS) != 0)
+    {
+        osal_printf("Failed to start the stats publisher\n");
+        if (sock != NULL)
+        {
+            osal_udp_close(sock);
+        }
+        osal_free(buffer);
+        return;
+    }
+    while (1)
+    {
+        osal_sleep_ms(publisher->interval_ms);
+        ccsds_metrics_sum(&total);
+        struct ccsds_conf* conf = ccsds_conf_acquire();
+        size_t len = ccsds_metrics_json(&total, &conf->table, buffer, size);
+        ccsds_conf_release(conf);
+        if (len > 0)
+        {
+            osal_udp_send(sock, &dest, buffer, len);
+        }
+    }
+}
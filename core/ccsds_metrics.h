@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     receive errors
+ * 2026-10-17   Nico Maas     stats datagram limited in size
+ * 2026-10-17   Nico Maas     sequence counters per APID
+ */
+
+#ifndef CCSDS_METRICS_H
+#define CCSDS_METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ccsds_apid.h"
+
+// blocks of different threads never share a cache line
+#ifndef CCSDS_CACHE_LINE
+#define CCSDS_CACHE_LINE            64
+#endif
+
+// log2 buckets in microseconds, bucket 0 holds 0 us, bucket i holds [2^(i-1), 2^i) us,
+// the last bucket everything above
+#define CCSDS_HISTOGRAM_BUCKETS     24
+
+struct ccsds_histogram
+{
+    uint32_t buckets[CCSDS_HISTOGRAM_BUCKETS];
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t sum_us;
+};
+
+// counters of one configured APID, indexed like the APID configuration
+struct ccsds_apid_metrics
+{
+    uint32_t packets;           // packets reassembled with correct length and CRC
+    uint32_t crc_errors;        // candidates of this APID rejected by the CRC check
+    uint32_t length_errors;     // candidates of this APID rejected by the length check
+    uint32_t pool_exhausted;    // packets skipped or segmented units dropped because the pool had no buffer
+    uint32_t gaps;              // jumps in the sequence count
+    uint32_t lost;              // packets missing according to the sequence count
+    uint32_t duplicates;        // packets repeating the last sequence count, dropped
+    uint32_t segment_errors;    // segmented user data dropped (missing first/last segment, gap, too long, no buffer)
+    uint64_t bytes;
+};
+
+// counters of one thread, only written by that thread, so no locking or atomics are needed
+// readers (console command, stats publisher) may see values which are a few events old
+struct ccsds_metrics
+{
+    struct ccsds_metrics* next;         // registered blocks
+    const char* name;
+    unsigned int apid_count;
+    struct ccsds_apid_metrics* apids;
+    // receiving
+    uint32_t datagrams;                 // datagrams received
+    uint32_t queue_drops;               // datagrams dropped because the incoming ring was full
+    uint32_t rx_errors;                 // failed receive calls, the datagrams lost with them are not known
+    uint64_t rx_bytes;
+    // TM Transfer Frame input
+    uint32_t frames;                    // frames accepted
+    uint32_t frame_errors;              // frames dropped by the FECF or header check
+    uint32_t frames_filtered;           // frames of other spacecraft or virtual channels and idle frames
+    uint32_t frames_lost;               // gaps in the virtual channel frame counts
+    uint32_t frame_sync_losses;         // ASM missing behind a frame, hunting for it again
+    uint32_t realigned;                 // state machines aligned again by a First Header Pointer
+    // reassembly
+    uint64_t hunt_bytes;                // bytes dropped while hunting for a SYNCWORD
+    uint32_t false_locks;               // candidates rejected by length or CRC check
+    uint64_t rescanned_bytes;           // bytes of rejected candidates searched again
+    uint32_t expired;                   // partial packets dropped by the inactivity timeout
+    uint32_t skipped_packets;           // packets of APIDs which are not configured, skipped while aligned
+    // forwarding
+    uint32_t egress_drops;              // packets dropped because the queue to the egress thread was full
+    uint32_t forwarded_packets;
+    uint32_t forwarded_datagrams;
+    uint32_t send_errors;
+    uint32_t unrouted_packets;          // packets of APIDs without a destination in the routing table
+    struct ccsds_histogram reassembly;  // arrival of the first byte of a packet until arrival of its last byte
+    struct ccsds_histogram latency;     // arrival of the last byte of a packet until its datagram is sent (ingest to forward)
+} __attribute__((aligned(CCSDS_CACHE_LINE)));
+
+// apid_count per-APID counters, 0 for a block which does not reassemble, 0 on success
+int ccsds_metrics_init(struct ccsds_metrics* metrics, const char* name, unsigned int apid_count);
+
+// make the block part of ccsds_metrics_sum, call once per block at startup
+void ccsds_metrics_register(struct ccsds_metrics* metrics);
+
+// add up all registered blocks into total (initialised with ccsds_metrics_init, not registered)
+void ccsds_metrics_sum(struct ccsds_metrics* total);
+
+static inline void ccsds_histogram_add(struct ccsds_histogram* histogram, uint64_t value_us)
+{
+    uint32_t value = (value_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)value_us;
+    unsigned int bucket = (value == 0) ? 0 : 32 - __builtin_clz(value);
+    if (bucket >= CCSDS_HISTOGRAM_BUCKETS)
+    {
+        bucket = CCSDS_HISTOGRAM_BUCKETS - 1;
+    }
+    histogram->buckets[bucket]++;
+    histogram->count++;
+    histogram->sum_us += value;
+    if (value > histogram->max_us)
+    {
+        histogram->max_us = value;
+    }
+}
+
+// upper bound in us of the bucket holding the given per mille of the values
+uint32_t ccsds_histogram_percentile(const struct ccsds_histogram* histogram, unsigned int per_mille);
+
+// print the counters and histograms of total to the console, apids is the APID configuration in use
+// (the per-APID counters are indexed by slot, empty slots are left out)
+void ccsds_metrics_print(const struct ccsds_metrics* total, const struct ccsds_apid_table* apids);
+
+// largest stats datagram
+#define CCSDS_METRICS_JSON_SIZE     16384
+
+// encode total as one line of JSON, returns the length or 0 if it does not fit into size bytes
+// APIDs without any count are left out, the ones which do not fit any more are counted in apids_omitted
+size_t ccsds_metrics_json(const struct ccsds_metrics* total, const struct ccsds_apid_table* apids, char* buffer, size_t size);
+
+// stats publisher, sends the JSON of all registered blocks every interval_ms as one datagram
+// the APIDs are the ones of the current configuration (ccsds_conf)
+struct ccsds_metrics_publisher
+{
+    const char* dest_ip;
+    uint16_t dest_port;
+    uint32_t interval_ms;
+};
+
+// thread entry, parameter is a struct ccsds_metrics_publisher
+// the JSON is formatted with vsnprintf (64 bit conversions), give the thread at least 4 KiB of stack
+void ccsds_metrics_thread(void* parameter);
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     nothing leaks if init fails
+ * 2026-10-17   Nico Maas     configuration a packet was reassembled under
+ */
+
+#include <string.h>
+
+#include "ccsds_pool.h"
+
+// free what ccsds_pool_init allocated before it failed
+static void pool_release(struct ccsds_pool* pool)
+{
+    for (unsigned int c = 0; c < pool->class_count; c++)
+    {
+        osal_free(pool->classes[c].memory);
+    }
+    osal_mutex_delete(pool->lock);
+    memset(pool, 0, sizeof(*pool));
+}
+
+int ccsds_pool_init(struct ccsds_pool* pool, const unsigned int pool_config[][2], unsigned int class_count)
+{
+    memset(pool, 0, sizeof(*pool));
+    if (class_count > CCSDS_POOL_MAX_CLASSES)
+    {
+        return -1;
+    }
+    pool->lock = osal_mutex_create("pool");
+    if (pool->lock == NULL)
+    {
+        return -1;
+    }
+    for (unsigned int c = 0; c < class_count; c++)
+    {
+        struct ccsds_pool_class* cls = &pool->classes[c];
+        // keep every buffer 8 byte aligned
+        uint32_t stride = (pool_config[c][0] + 7) & ~7U;
+        uint32_t count = pool_config[c][1];
+        if (c > 0 && pool_config[c][0] <= pool->classes[c - 1].buffer_size)
+        {
+            pool_release(pool);
+            return -1;
+        }
+        // descriptors and data of one class in a single allocation
+        uint8_t* memory = osal_malloc(count * sizeof(struct ccsds_buffer) + (size_t)count * stride);
+        if (memory == NULL)
+        {
+            pool_release(pool);
+            return -1;
+        }
+        struct ccsds_buffer* buffers = (struct ccsds_buffer*)memory;
+        uint8_t* data = memory + count * sizeof(struct ccsds_buffer);
+        cls->buffer_size = pool_config[c][0];
+        cls->count = count;
+        cls->available = count;
+        cls->free = NULL;
+        cls->memory = memory;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            buffers[i].pool = pool;
+            buffers[i].pool_class = c;
+            buffers[i].size = cls->buffer_size;
+            buffers[i].length = 0;
+            buffers[i].data = data + (size_t)i * stride;
+            buffers[i].next = cls->free;
+            cls->free = &buffers[i];
+        }
+        pool->class_count++;
+    }
+    return 0;
+}
+
+struct ccsds_buffer* ccsds_pool_alloc(struct ccsds_pool* pool, uint32_t size)
+{
+    struct ccsds_buffer* buffer = NULL;
+    osal_mutex_lock(pool->lock);
+    for (unsigned int c = 0; c < pool->class_count; c++)
+    {
+        struct ccsds_pool_class* cls = &pool->classes[c];
+        if (cls->buffer_size >= size && cls->free != NULL)
+        {
+            buffer = cls->free;
+            cls->free = buffer->next;
+            cls->available--;
+            break;
+        }
+    }
+    if (buffer == NULL && size <= ccsds_pool_max_size(pool))
+    {
+        pool->exhausted++;
+    }
+    osal_mutex_unlock(pool->lock);
+    if (buffer != NULL)
+    {
+        buffer->next = NULL;
+        buffer->length = 0;
+        buffer->refs = 1;
+        buffer->apids = NULL;
+    }
+    return buffer;
+}
+
+uint32_t ccsds_pool_max_size(const struct ccsds_pool* pool)
+{
+    return (pool->class_count > 0) ? pool->classes[pool->class_count - 1].buffer_size : 0;
+}
+
+void ccsds_buffer_free(struct ccsds_buffer* buffer)
+{
+    if (__atomic_sub_fetch(&buffer->refs, 1, __ATOMIC_ACQ_REL) != 0)
+    {
+        return;
+    }
+    struct ccsds_pool* pool = buffer->pool;
+    struct ccsds_pool_class* cls = &pool->classes[buffer->pool_class];
+    osal_mutex_lock(pool->lock);
+    buffer->next = cls->free;
+    cls->free = buffer;
+    cls->available++;
+    osal_mutex_unlock(pool->lock);
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     nothing leaks if init fails
+ * 2026-10-17   Nico Maas     configuration a packet was reassembled under
+ */
+
+#ifndef CCSDS_POOL_H
+#define CCSDS_POOL_H
+
+#include <stdint.h>
+
+#include "osal.h"
+
+// largest Space Packet: 6 byte primary header and 65536 byte data field (incl. CRC)
+#define CCSDS_PRIMARY_HEADER_SIZE   6
+#define CCSDS_MAX_PACKET_SIZE       (CCSDS_PRIMARY_HEADER_SIZE + 65536)
+
+#define CCSDS_POOL_MAX_CLASSES      8
+
+struct ccsds_pool;
+struct ccsds_apid_table;
+
+// packet buffer handed out by the pool
+struct ccsds_buffer
+{
+    struct ccsds_buffer* next;  // free list link while the buffer is in the pool
+    struct ccsds_pool* pool;
+    uint8_t pool_class;
+    uint32_t size;              // capacity of data
+    uint32_t length;            // bytes of data in use
+    uint64_t timestamp;         // arrival time of the data which completed the packet
+    uint32_t refs;              // holders of the buffer, it returns to the pool when the last one frees it
+    const struct ccsds_apid_table* apids;   // configuration the packet was reassembled under, NULL if not known
+    uint8_t* data;
+};
+
+struct ccsds_pool_class
+{
+    uint32_t buffer_size;
+    uint32_t count;
+    uint32_t available;
+    struct ccsds_buffer* free;
+    uint8_t* memory;            // descriptors and data of the class, one allocation
+};
+
+// fixed-size, size-classed buffer pool
+// all memory is allocated once by ccsds_pool_init, alloc and free never call malloc
+// free may be called from a different thread than alloc
+struct ccsds_pool
+{
+    struct ccsds_pool_class classes[CCSDS_POOL_MAX_CLASSES];    // ascending buffer sizes
+    unsigned int class_count;
+    osal_mutex_t lock;
+    uint32_t exhausted;         // allocations that failed because all fitting buffers were in use
+};
+
+// pool_config holds tuples of buffer size and number of buffers, ascending by size
+// returns -1 if the configuration is invalid or an allocation fails, nothing stays allocated then
+int ccsds_pool_init(struct ccsds_pool* pool, const unsigned int pool_config[][2], unsigned int class_count);
+
+// smallest free buffer with at least size bytes, falls back to larger classes
+// NULL if size exceeds the largest class or if no fitting buffer is free (counted in exhausted)
+struct ccsds_buffer* ccsds_pool_alloc(struct ccsds_pool* pool, uint32_t size);
+
+// largest buffer the pool can hand out
+uint32_t ccsds_pool_max_size(const struct ccsds_pool* pool);
+
+// one more holder of the buffer (e.g. one more destination of a packet), it has to call ccsds_buffer_free as well
+static inline void ccsds_buffer_ref(struct ccsds_buffer* buffer)
+{
+    __atomic_add_fetch(&buffer->refs, 1, __ATOMIC_RELAXED);
+}
+
+// release a buffer, the last holder returns it to its pool
+void ccsds_buffer_free(struct ccsds_buffer* buffer);
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ */
+
+#include "ccsds_queue.h"
+
+int ccsds_queue_init(struct ccsds_queue* queue, const char* name, void** slots, uint32_t size)
+{
+    if (size == 0 || (size & (size - 1)) != 0)
+    {
+        return -1;
+    }
+    queue->slots = slots;
+    queue->size = size;
+    queue->head = 0;
+    queue->tail = 0;
+    if (name == NULL)
+    {
+        queue->sem = NULL;
+        return 0;
+    }
+    queue->sem = osal_sem_create(name, 0);
+    return (queue->sem != NULL) ? 0 : -1;
+}
+
+int ccsds_queue_push(struct ccsds_queue* queue, void* item)
+{
+    uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= queue->size)
+    {
+        return -1;
+    }
+    queue->slots[head & (queue->size - 1)] = item;
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+    if (queue->sem != NULL)
+    {
+        osal_sem_give(queue->sem);
+    }
+    return 0;
+}
+
+void* ccsds_queue_pop(struct ccsds_queue* queue, int32_t timeout_ms)
+{
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+    if (queue->sem != NULL)
+    {
+        if (osal_sem_take(queue->sem, timeout_ms) != 0)
+        {
+            return NULL;
+        }
+    }
+    else if (__atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) == tail)
+    {
+        return NULL;
+    }
+    void* item = queue->slots[tail & (queue->size - 1)];
+    __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+    return item;
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ */
+
+#ifndef CCSDS_QUEUE_H
+#define CCSDS_QUEUE_H
+
+#include <stdint.h>
+
+#include "osal.h"
+
+// single-producer / single-consumer queue of pointers (received datagrams, packet buffers)
+// the ring itself is lock-free, the semaphore only wakes up a waiting consumer
+// one push and one pop per item, never per byte
+struct ccsds_queue
+{
+    void** slots;       // storage provided by the caller
+    uint32_t size;      // number of slots, must be a power of two
+    uint32_t head;      // only written by the producer
+    uint32_t tail;      // only written by the consumer
+    osal_sem_t sem;     // counts the items waiting in the ring, NULL for a polled queue
+};
+
+// name NULL creates a polled queue without semaphore, e.g. if one consumer serves several queues
+// and waits on a semaphore of its own, pop never blocks then
+int ccsds_queue_init(struct ccsds_queue* queue, const char* name, void** slots, uint32_t size);
+int ccsds_queue_push(struct ccsds_queue* queue, void* item);         // 0 on success, -1 if the queue is full
+void* ccsds_queue_pop(struct ccsds_queue* queue, int32_t timeout_ms); // NULL on timeout or if a polled queue is empty
+
+#endif
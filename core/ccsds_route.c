@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ */
+
+#include <string.h>
+
+#include "ccsds_route.h"
+
+// index of the destination in the table, added if it is new, -1 if the table is full
+static int route_dest(struct ccsds_route_table* table, const struct osal_addr* addr)
+{
+    for (unsigned int i = 0; i < table->dest_count; i++)
+    {
+        if (table->addr[i].ip == addr->ip && table->addr[i].port == addr->port)
+        {
+            return i;
+        }
+    }
+    if (table->dest_count == CCSDS_ROUTE_MAX_DESTS)
+    {
+        return -1;
+    }
+    table->addr[table->dest_count] = *addr;
+    return table->dest_count++;
+}
+
+// index of the destination ip:port, -1 on an invalid address or a full table
+static int route_resolve(struct ccsds_route_table* table, const char* ip, uint16_t port)
+{
+    struct osal_addr addr;
+    if (osal_udp_resolve(ip, port, &addr) != 0)
+    {
+        return -1;
+    }
+    return route_dest(table, &addr);
+}
+
+static void route_set(struct ccsds_route_table* table, unsigned int first, unsigned int last, int dest)
+{
+    for (unsigned int apid = first; apid <= last; apid++)
+    {
+        table->dests[apid] |= 1 << dest;
+    }
+}
+
+// APIDs without destinations get the default ones
+static void route_default(struct ccsds_route_table* table, uint16_t dests)
+{
+    for (unsigned int apid = 0; apid < 2048; apid++)
+    {
+        if (table->dests[apid] == 0)
+        {
+            table->dests[apid] = dests;
+        }
+    }
+}
+
+static struct ccsds_route_table* route_table_alloc(void)
+{
+    struct ccsds_route_table* table = osal_malloc(sizeof(struct ccsds_route_table));
+    if (table != NULL)
+    {
+        memset(table, 0, sizeof(*table));
+    }
+    return table;
+}
+
+struct ccsds_route_table* ccsds_route_table_create(const struct ccsds_route_config* config, unsigned int count,
+                                                   const char* default_ip, uint16_t default_port)
+{
+    struct ccsds_route_table* table = route_table_alloc();
+    if (table == NULL)
+    {
+        return NULL;
+    }
+    for (unsigned int i = 0; i < count; i++)
+    {
+        int dest = route_resolve(table, config[i].dest_ip, config[i].dest_port);
+        if (dest < 0 || config[i].apid_first > config[i].apid_last || config[i].apid_last > 0x7FF)
+        {
+            osal_free(table);
+            return NULL;
+        }
+        route_set(table, config[i].apid_first, config[i].apid_last, dest);
+    }
+    if (default_ip != NULL)
+    {
+        int dest = route_resolve(table, default_ip, default_port);
+        if (dest < 0)
+        {
+            osal_free(table);
+            return NULL;
+        }
+        route_default(table, 1 << dest);
+    }
+    return table;
+}
+
+// next whitespace separated token of the current rule, its length is returned in len, NULL at the end of the rule
+static const char* route_token(const char** text, size_t* len)
+{
+    const char* p = *text;
+    while (*p == ' ' || *p == '\t' || *p == '\r')
+    {
+        p++;
+    }
+    // a comment runs until the end of the line
+    if (*p == '#')
+    {
+        while (*p != '\0' && *p != '\n')
+        {
+            p++;
+        }
+    }
+    *text = p;
+    if (*p == '\0' || *p == '\n' || *p == ';')
+    {
+        return NULL;
+    }
+    const char* start = p;
+    while (*p != '\0' && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n' && *p != ';' && *p != '#')
+    {
+        p++;
+    }
+    *len = p - start;
+    *text = p;
+    return start;
+}
+
+// "ip:port" into an address string and port, -1 if it does not fit
+static int route_parse_dest(const char* token, size_t len, char* ip, size_t ip_size, uint16_t* port)
+{
+    const char* colon = memchr(token, ':', len);
+    if (colon == NULL || (size_t)(colon - token) >= ip_size)
+    {
+        return -1;
+    }
+    memcpy(ip, token, colon - token);
+    ip[colon - token] = '\0';
+    long value = 0;
+    for (const char* p = colon + 1; p < token + len; p++)
+    {
+        if (*p < '0' || *p > '9')
+        {
+            return -1;
+        }
+        value = value * 10 + (*p - '0');
+        if (value > 65535)
+        {
+            return -1;
+        }
+    }
+    if (value == 0)
+    {
+        return -1;
+    }
+    *port = (uint16_t)value;
+    return 0;
+}
+
+// "first[-last]" or "*" (all set)
+static int route_parse_apids(const char* token, size_t len, unsigned int* first, unsigned int* last, int* all)
+{
+    *all = (len == 1 && token[0] == '*');
+    if (*all)
+    {
+        return 0;
+    }
+    unsigned int value[2] = { 0, 0 };
+    unsigned int n = 0;
+    int digits = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (token[i] == '-' && n == 0 && digits > 0)
+        {
+            n = 1;
+            digits = 0;
+        }
+        else if (token[i] >= '0' && token[i] <= '9' && value[n] < 0x800)
+        {
+            value[n] = value[n] * 10 + (token[i] - '0');
+            digits++;
+        }
+        else
+        {
+            return -1;
+        }
+    }
+    if (digits == 0)
+    {
+        return -1;
+    }
+    *first = value[0];
+    *last = (n == 1) ? value[1] : value[0];
+    return (*first <= *last && *last <= 0x7FF) ? 0 : -1;
+}
+
+struct ccsds_route_table* ccsds_route_table_parse(const char* text)
+{
+    struct ccsds_route_table* table = route_table_alloc();
+    if (table == NULL)
+    {
+        return NULL;
+    }
+    uint16_t defaults = 0;
+    int error = 0;
+    while (*text != '\0' && !error)
+    {
+        size_t len;
+        const char* token = route_token(&text, &len);
+        if (token != NULL)
+        {
+            unsigned int first = 0, last = 0;
+            int all;
+            if (route_parse_apids(token, len, &first, &last, &all) != 0)
+            {
+                error = 1;
+                break;
+            }
+            int dests = 0;
+            while ((token = route_token(&text, &len)) != NULL)
+            {
+                char ip[16];
+                uint16_t port;
+                int dest = (route_parse_dest(token, len, ip, sizeof(ip), &port) == 0) ? route_resolve(table, ip, port) : -1;
+                if (dest < 0)
+                {
+                    break;
+                }
+                // the default destinations are applied once all rules are known
+                if (all)
+                {
+                    defaults |= 1 << dest;
+                }
+                else
+                {
+                    route_set(table, first, last, dest);
+                }
+                dests++;
+            }
+            // a rule needs at least one destination and all of them have to be valid
+            if (token != NULL || dests == 0)
+            {
+                error = 1;
+                break;
+            }
+        }
+        // end of the rule
+        if (*text != '\0')
+        {
+            text++;
+        }
+    }
+    if (error)
+    {
+        osal_free(table);
+        return NULL;
+    }
+    route_default(table, defaults);
+    return table;
+}
+
+void ccsds_route_table_free(struct ccsds_route_table* table)
+{
+    osal_free(table);
+}
+
+void ccsds_route_table_print(const struct ccsds_route_table* table)
+{
+    unsigned int first = 0;
+    for (unsigned int apid = 1; apid <= 2048; apid++)
+    {
+        if (apid < 2048 && table->dests[apid] == table->dests[first])
+        {
+            continue;
+        }
+        if (table->dests[first] != 0)
+        {
+            osal_printf((first == apid - 1) ? "%u" : "%u-%u", first, apid - 1);
+            for (unsigned int i = 0; i < table->dest_count; i++)
+            {
+                if (table->dests[first] & (1 << i))
+                {
+                    const uint8_t* ip = (const uint8_t*)&table->addr[i].ip;
+                    osal_printf(" %u.%u.%u.%u:%u", ip[0], ip[1], ip[2], ip[3], table->addr[i].port);
+                }
+            }
+            osal_printf("\n");
+        }
+        first = apid;
+    }
+}
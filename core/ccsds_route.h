@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ */
+
+#ifndef CCSDS_ROUTE_H
+#define CCSDS_ROUTE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "osal.h"
+
+// destinations of one routing table, a packet can go to any subset of them
+#define CCSDS_ROUTE_MAX_DESTS   16
+
+// one rule of the routing configuration: packets of the APIDs apid_first..apid_last go to dest_ip:dest_port
+// several rules for the same APIDs send the packets to all their destinations (fan-out)
+struct ccsds_route_config
+{
+    uint16_t apid_first;        // [0-2047]
+    uint16_t apid_last;         // [apid_first-2047]
+    const char* dest_ip;
+    uint16_t dest_port;
+};
+
+// routing table compiled out of the rules
+// the destinations of a packet are one array lookup: a bit per destination for every possible APID
+struct ccsds_route_table
+{
+    uint16_t dests[2048];                               // APID -> bit per destination, 0: not routed
+    struct osal_addr addr[CCSDS_ROUTE_MAX_DESTS];
+    unsigned int dest_count;
+};
+
+// compile the rules, APIDs no rule covers go to default_ip:default_port (default_ip NULL: they are dropped)
+// returns a table allocated with osal_malloc or NULL if an address is invalid or there are too many destinations
+struct ccsds_route_table* ccsds_route_table_create(const struct ccsds_route_config* config, unsigned int count,
+                                                   const char* default_ip, uint16_t default_port);
+
+// compile rules given as text: rules separated by newlines or ';', each "first[-last] ip:port [ip:port ...]",
+// "*" instead of the APIDs sets the destinations of all APIDs no other rule covers, '#' starts a comment
+// returns NULL on a syntax error
+struct ccsds_route_table* ccsds_route_table_parse(const char* text);
+
+void ccsds_route_table_free(struct ccsds_route_table* table);
+
+// bit per destination of the packets of apid
+static inline uint16_t ccsds_route_lookup(const struct ccsds_route_table* table, uint16_t apid)
+{
+    return table->dests[apid & 0x7FF];
+}
+
+// print the rules of a table to the console, one line per group of APIDs with the same destinations
+void ccsds_route_table_print(const struct ccsds_route_table* table);
+
+#endif
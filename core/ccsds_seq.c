@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     configuration replaceable at runtime
+ * 2026-10-17   Nico Maas     join buffers sized by max_length
+ * 2026-10-17   Nico Maas     ccsds_seq_deinit
+ * 2026-10-17   Nico Maas     sequence counters in the per-APID metrics
+ * 2026-10-17   Nico Maas     packets checked under the configuration they were reassembled under
+ */
+
+#include <string.h>
+
+#include "ccsds_crc16.h"
+#include "ccsds_seq.h"
+#include "ccsds_trace.h"
+#include "osal.h"
+
+int ccsds_seq_init(struct ccsds_seq* seq, const struct ccsds_apid_table* apids, struct ccsds_pool* pool,
+                   struct ccsds_metrics* metrics, uint8_t join, ccsds_packet_cb packet_cb, void* packet_cb_arg)
+{
+    seq->apids = apids;
+    seq->pool = pool;
+    seq->metrics = metrics;
+    seq->join = join;
+    seq->packet_cb = packet_cb;
+    seq->packet_cb_arg = packet_cb_arg;
+    // every slot, a configuration loaded later may use more of them
+    seq->contexts = osal_malloc(CCSDS_APID_SLOTS * sizeof(struct ccsds_apid_context));
+    if (seq->contexts == NULL)
+    {
+        return -1;
+    }
+    memset(seq->contexts, 0, CCSDS_APID_SLOTS * sizeof(struct ccsds_apid_context));
+    return 0;
+}
+
+void ccsds_seq_deinit(struct ccsds_seq* seq)
+{
+    for (unsigned int i = 0; i < CCSDS_APID_SLOTS; i++)
+    {
+        if (seq->contexts[i].unit != NULL)
+        {
+            ccsds_buffer_free(seq->contexts[i].unit);
+        }
+    }
+    osal_free(seq->contexts);
+    seq->contexts = NULL;
+}
+
+void ccsds_seq_set_apids(struct ccsds_seq* seq, const struct ccsds_apid_table* apids)
+{
+    seq->apids = apids;
+}
+
+// drop the segments joined so far
+static void seq_drop_unit(struct ccsds_apid_context* context, struct ccsds_apid_metrics* counters)
+{
+    if (context->unit != NULL)
+    {
+        ccsds_buffer_free(context->unit);
+        context->unit = NULL;
+        counters->segment_errors++;
+    }
+}
+
+// append the data field of a segment (without its CRC) to the open unit
+static int seq_append(struct ccsds_apid_context* context, const uint8_t* data, uint32_t length)
+{
+    if (context->unit->length + length > context->unit->size)
+    {
+        return -1;
+    }
+    memcpy(&context->unit->data[context->unit->length], data, length);
+    context->unit->length += length;
+    return 0;
+}
+
+void ccsds_seq_packet(void* arg, struct ccsds_buffer* packet)
+{
+    struct ccsds_seq* seq = arg;
+    const uint8_t* data = packet->data;
+    uint16_t apid = (data[0] & 0x07) << 8 | data[1];
+    // the CRC and length of the packet were checked under the configuration of the state machine, which
+    // switches at a packet boundary: packets still completed under the previous one keep its settings
+    const struct ccsds_apid_table* apids = (packet->apids != NULL) ? packet->apids : seq->apids;
+    uint16_t slot = apids->slot[apid];
+    const struct ccsds_apid_config* config = &apids->config[slot];
+    struct ccsds_apid_context* context = &seq->contexts[slot];
+    uint8_t flags = data[2] >> 6;
+    uint16_t count = (data[2] & 0x3F) << 8 | data[3];
+
+    // an APID which is not configured (any more), pass it on as it is
+    if (slot >= apids->count || config->apid != apid)
+    {
+        seq->packet_cb(seq->packet_cb_arg, packet);
+        return;
+    }
+    struct ccsds_apid_metrics* counters = &seq->metrics->apids[slot];
+    // the slot was given to another APID at runtime, its sequence starts over
+    if (context->apid != apid)
+    {
+        if (context->unit != NULL)
+        {
+            ccsds_buffer_free(context->unit);
+        }
+        memset(context, 0, sizeof(*context));
+        context->apid = apid;
+    }
+
+    // check the 14 bit sequence count against the last one of this APID
+    if (context->valid)
+    {
+        if (count == context->last_count)
+        {
+            counters->duplicates++;
+            CCSDS_TRACE_ERROR(CCSDS_TRACE_SEQ_DUPLICATE, apid, count);
+            ccsds_buffer_free(packet);
+            return;
+        }
+        uint16_t expected = (context->last_count + 1) & 0x3FFF;
+        if (count != expected)
+        {
+            counters->gaps++;
+            counters->lost += (count - expected) & 0x3FFF;
+            CCSDS_TRACE_ERROR(CCSDS_TRACE_SEQ_GAP, apid, (count - expected) & 0x3FFF);
+            // segments are missing, the open unit cannot be completed anymore
+            seq_drop_unit(context, counters);
+        }
+    }
+    context->last_count = count;
+    context->valid = 1;
+
+    if (!seq->join || flags == CCSDS_SEQ_UNSEGMENTED)
+    {
+        // an unsegmented packet ends any unit still open
+        if (flags == CCSDS_SEQ_UNSEGMENTED)
+        {
+            seq_drop_unit(context, counters);
+        }
+        seq->packet_cb(seq->packet_cb_arg, packet);
+        return;
+    }
+
+    uint32_t crc_length = config->crc ? 2 : 0;
+    // the settings of the APID changed since the unit was opened, its segments do not fit together
+    if (context->unit != NULL && (context->unit_crc != config->crc || context->unit_max_length != config->max_length))
+    {
+        seq_drop_unit(context, counters);
+    }
+    if (flags == CCSDS_SEQ_FIRST)
+    {
+        // the previous unit never got its last segment
+        seq_drop_unit(context, counters);
+        // a buffer of the size the unit may reach, so open units of several APIDs do not take all
+        // of the largest buffers the state machine needs for long packets
+        uint32_t size = ccsds_pool_max_size(seq->pool);
+        if (config->max_length != 0 && config->max_length < size)
+        {
+            size = config->max_length;
+        }
+        context->unit = ccsds_pool_alloc(seq->pool, size);
+        if (context->unit == NULL)
+        {
+            counters->segment_errors++;
+            counters->pool_exhausted++;
+            CCSDS_TRACE_ERROR(CCSDS_TRACE_FSM_POOL_EXHAUSTED, apid, size);
+        }
+        else
+        {
+            context->unit->apids = apids;
+            context->unit_crc = config->crc;
+            context->unit_max_length = config->max_length;
+            seq_append(context, data, packet->length - crc_length);
+        }
+    }
+    else if (context->unit == NULL)
+    {
+        // continuation or last segment without first segment
+        counters->segment_errors++;
+    }
+    else if (seq_append(context, &data[CCSDS_PRIMARY_HEADER_SIZE], packet->length - CCSDS_PRIMARY_HEADER_SIZE - crc_length) != 0
+             || context->unit->length + crc_length > context->unit->size
+             || (config->max_length != 0 && context->unit->length + crc_length > config->max_length)
+             || context->unit->length + crc_length > CCSDS_MAX_PACKET_SIZE)
+    {
+        // the joined unit would not fit into the buffer or a Space Packet
+        seq_drop_unit(context, counters);
+    }
+    else if (flags == CCSDS_SEQ_LAST)
+    {
+        struct ccsds_buffer* unit = context->unit;
+        context->unit = NULL;
+        unit->timestamp = packet->timestamp;
+        uint32_t data_length = unit->length - CCSDS_PRIMARY_HEADER_SIZE + crc_length - 1;
+        unit->data[2] |= CCSDS_SEQ_UNSEGMENTED << 6;
+        unit->data[4] = data_length >> 8;
+        unit->data[5] = data_length & 0xFF;
+        if (config->crc)
+        {
+            uint16_t crc = ccsds_crc16_update(CCSDS_CRC16_INIT, unit->data, unit->length);
+            unit->data[unit->length++] = crc >> 8;
+            unit->data[unit->length++] = crc & 0xFF;
+        }
+        CCSDS_TRACE_INFO(CCSDS_TRACE_SEQ_JOINED, apid, unit->length);
+        seq->packet_cb(seq->packet_cb_arg, unit);
+    }
+    ccsds_buffer_free(packet);
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     configuration replaceable at runtime
+ * 2026-10-17   Nico Maas     ccsds_seq_deinit
+ * 2026-10-17   Nico Maas     sequence counters in the per-APID metrics
+ * 2026-10-17   Nico Maas     packets checked under the configuration they were reassembled under
+ */
+
+#ifndef CCSDS_SEQ_H
+#define CCSDS_SEQ_H
+
+#include <stdint.h>
+
+#include "ccsds_apid.h"
+#include "ccsds_fsm.h"
+#include "ccsds_metrics.h"
+#include "ccsds_pool.h"
+
+// sequence flags of the primary header
+#define CCSDS_SEQ_CONTINUATION  0
+#define CCSDS_SEQ_FIRST         1
+#define CCSDS_SEQ_LAST          2
+#define CCSDS_SEQ_UNSEGMENTED   3
+
+// state of one configured APID, its counters are part of the per-APID metrics (gaps, lost, duplicates,
+// segment_errors)
+struct ccsds_apid_context
+{
+    uint16_t apid;                  // APID the context belongs to
+    uint16_t last_count;            // 14 bit sequence count of the last packet
+    uint8_t valid;                  // last_count has been set
+    struct ccsds_buffer* unit;      // segments joined so far, NULL if no segmented user data is open
+    uint8_t unit_crc;               // crc and max_length of the APID when the unit was opened, a segment
+    uint32_t unit_max_length;       // reassembled under other ones does not belong to it
+};
+
+// sequence count tracking and joining of segmented user data, sits between state machine and forwarding
+// the contexts live in one flat array indexed by the slot of the APID in the configuration
+struct ccsds_seq
+{
+    const struct ccsds_apid_table* apids;
+    struct ccsds_apid_context* contexts;
+    struct ccsds_pool* pool;
+    struct ccsds_metrics* metrics;  // per-APID counters of the sequence checks, indexed by slot like the contexts
+    uint8_t join;                   // join segmented user data (1) or forward every segment as it is (0)
+    ccsds_packet_cb packet_cb;      // receives unsegmented packets and joined units
+    void* packet_cb_arg;
+};
+
+// allocates one context per APID slot (CCSDS_APID_SLOTS), returns -1 if that fails
+// a joined unit is limited to max_length of its APID (the largest pool buffer if that is not set)
+int ccsds_seq_init(struct ccsds_seq* seq, const struct ccsds_apid_table* apids, struct ccsds_pool* pool,
+                   struct ccsds_metrics* metrics, uint8_t join, ccsds_packet_cb packet_cb, void* packet_cb_arg);
+
+// drop the open units and free the contexts
+void ccsds_seq_deinit(struct ccsds_seq* seq);
+
+// use another configuration from the next packet on, the contexts of APIDs keeping their slot are kept
+// a packet is checked under the configuration the state machine reassembled it under (ccsds_buffer apids),
+// this one is only used for packets which do not carry one
+// packets of APIDs the configuration does not have are passed on without sequence checks
+void ccsds_seq_set_apids(struct ccsds_seq* seq, const struct ccsds_apid_table* apids);
+
+// ccsds_packet_cb compatible, arg is the struct ccsds_seq, takes ownership of the packet
+// Segments are joined into one packet: primary header of the first segment with sequence flags
+// set to unsegmented and the data length of the joined unit, the data fields of all segments
+// without their CRC and a new CRC over the unit (if the APID uses one).
+void ccsds_seq_packet(void* arg, struct ccsds_buffer* packet);
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ */
+
+#include <stdint.h>
+
+#include "ccsds_trace.h"
+#include "osal.h"
+
+#if (CCSDS_TRACE_SIZE & (CCSDS_TRACE_SIZE - 1)) != 0
+#error "CCSDS_TRACE_SIZE must be a power of two"
+#endif
+
+static struct ccsds_trace_entry trace_ring[CCSDS_TRACE_SIZE];
+static uint32_t trace_head;     // next index to write, shared by all writers
+static uint32_t trace_tail;     // next index to dump, only used by the dumping thread
+static uint8_t trace_busy;      // a dump is running
+static uint32_t trace_lost;     // entries overwritten before they were dumped
+
+static const char* const trace_format[CCSDS_TRACE_EVENT_COUNT] =
+{
+    [CCSDS_TRACE_FSM_LOCK]              = "ok: mode 0->2, apid %u",
+    [CCSDS_TRACE_FSM_HEADER]            = "ok: mode 2->21, sequence flags %u, count %u",
+    [CCSDS_TRACE_FSM_LENGTH]            = "ok: mode 21->22, packet of %u bytes",
+    [CCSDS_TRACE_FSM_PAYLOAD]           = "ok: mode 22->23 with %u bytes payload loaded",
+    [CCSDS_TRACE_FSM_PACKET]            = "apid %u: packet of %u bytes complete",
+    [CCSDS_TRACE_FSM_LENGTH_ERROR]      = "length error (%u, max %u), rescanning",
+    [CCSDS_TRACE_FSM_CRC_ERROR]         = "chksum error (sent: %u, computed: %u), rescanning",
+    [CCSDS_TRACE_FSM_POOL_EXHAUSTED]    = "apid %u: pool exhausted, skipping packet of %u bytes",
+    [CCSDS_TRACE_FSM_RESCAN]            = "rescanning %u bytes",
+    [CCSDS_TRACE_FSM_EXPIRED]           = "partial packet expired in mode %u after %u bytes",
+    [CCSDS_TRACE_FRAME_FECF_ERROR]      = "frame FECF error (sent: %u, computed: %u), dropped",
+    [CCSDS_TRACE_FRAME_SYNC]            = "ASM found, %u bytes skipped",
+    [CCSDS_TRACE_FRAME_GAP]             = "vc %u: %u frames lost",
+    [CCSDS_TRACE_FRAME_ALIGN]           = "vc %u: aligned at first header pointer %u",
+    [CCSDS_TRACE_SEQ_DUPLICATE]         = "apid %u: duplicate sequence count %u, dropped",
+    [CCSDS_TRACE_SEQ_GAP]               = "apid %u: sequence gap, %u packets lost",
+    [CCSDS_TRACE_SEQ_JOINED]            = "apid %u: joined segments into %u bytes",
+    [CCSDS_TRACE_FORWARD_ERROR]         = "%u datagrams could not be sent",
+    [CCSDS_TRACE_FORWARD_ROUTES]        = "routing table with %u destinations in use",
+};
+
+// a handful of stores, safe to call from any thread
+void ccsds_trace_record(uint32_t event, uint32_t arg0, uint32_t arg1)
+{
+    uint32_t index = __atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED);
+    struct ccsds_trace_entry* entry = &trace_ring[index & (CCSDS_TRACE_SIZE - 1)];
+    // invalidate the entry first, so a dump running concurrently notices it is rewritten
+    __atomic_store_n(&entry->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&entry->time_us, (uint32_t)osal_time_us(), __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->event, event, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->arg[0], arg0, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->arg[1], arg1, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->seq, index + 1, __ATOMIC_RELEASE);
+}
+
+unsigned int ccsds_trace_dump(void)
+{
+    if (__atomic_test_and_set(&trace_busy, __ATOMIC_ACQUIRE))
+    {
+        return 0;
+    }
+    unsigned int printed = 0;
+    uint32_t head = __atomic_load_n(&trace_head, __ATOMIC_ACQUIRE);
+    // the writers lapped the dump, the oldest entries are gone
+    if (head - trace_tail > CCSDS_TRACE_SIZE)
+    {
+        trace_lost += head - trace_tail - CCSDS_TRACE_SIZE;
+        trace_tail = head - CCSDS_TRACE_SIZE;
+    }
+    while (trace_tail != head)
+    {
+        const struct ccsds_trace_entry* entry = &trace_ring[trace_tail & (CCSDS_TRACE_SIZE - 1)];
+        uint32_t seq = __atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE);
+        if (seq == 0 || (int32_t)(seq - (trace_tail + 1)) < 0)
+        {
+            // claimed but not written completely yet, dump it next time
+            break;
+        }
+        struct ccsds_trace_entry copy;
+        copy.time_us = __atomic_load_n(&entry->time_us, __ATOMIC_RELAXED);
+        copy.event = __atomic_load_n(&entry->event, __ATOMIC_RELAXED);
+        copy.arg[0] = __atomic_load_n(&entry->arg[0], __ATOMIC_RELAXED);
+        copy.arg[1] = __atomic_load_n(&entry->arg[1], __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (seq != trace_tail + 1 || __atomic_load_n(&entry->seq, __ATOMIC_RELAXED) != seq)
+        {
+            // overwritten by a newer entry
+            trace_lost++;
+            trace_tail++;
+            continue;
+        }
+        osal_printf("[%10u] ", (unsigned int)copy.time_us);
+        if (copy.event < CCSDS_TRACE_EVENT_COUNT)
+        {
+            osal_printf(trace_format[copy.event], (unsigned int)copy.arg[0], (unsigned int)copy.arg[1]);
+        }
+        else
+        {
+            osal_printf("event %u (%u, %u)", (unsigned int)copy.event, (unsigned int)copy.arg[0], (unsigned int)copy.arg[1]);
+        }
+        osal_printf("\n");
+        trace_tail++;
+        printed++;
+    }
+    if (trace_lost != 0)
+    {
+        osal_printf("trace: %u entries lost\n", (unsigned int)trace_lost);
+        trace_lost = 0;
+    }
+    __atomic_clear(&trace_busy, __ATOMIC_RELEASE);
+    return printed;
+}
+
+void ccsds_trace_thread(void* parameter)
+{
+    uint32_t interval_ms = (uint32_t)(uintptr_t)parameter;
+    while (1)
+    {
+        ccsds_trace_dump();
+        osal_sleep_ms(interval_ms);
+    }
+}
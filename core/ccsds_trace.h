@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     errors only by default
+ */
+
+#ifndef CCSDS_TRACE_H
+#define CCSDS_TRACE_H
+
+#include <stdint.h>
+
+// binary event trace, replaces printing to the console in the hot path
+// recording an event stores a timestamp, the event id and two arguments in a lock-free ring,
+// formatting only happens when the ring is dumped (drain thread or console command)
+
+// trace levels, events above CCSDS_TRACE_LEVEL are not compiled in at all
+#define CCSDS_TRACE_LEVEL_OFF       0
+#define CCSDS_TRACE_LEVEL_ERROR     1   // rejected candidates, exhausted pool, sequence errors
+#define CCSDS_TRACE_LEVEL_INFO      2   // forwarded packets
+#define CCSDS_TRACE_LEVEL_DEBUG     3   // every mode transition of the state machine
+
+// INFO records every packet, the drain thread would print a line per packet: only errors by default
+#ifndef CCSDS_TRACE_LEVEL
+#define CCSDS_TRACE_LEVEL           CCSDS_TRACE_LEVEL_ERROR
+#endif
+
+// number of entries in the ring, power of two, the oldest entries are overwritten
+#ifndef CCSDS_TRACE_SIZE
+#define CCSDS_TRACE_SIZE            256
+#endif
+
+enum ccsds_trace_event
+{
+    CCSDS_TRACE_FSM_LOCK,           // mode 0->2, apid
+    CCSDS_TRACE_FSM_HEADER,         // mode 2->21, sequence flags and count
+    CCSDS_TRACE_FSM_LENGTH,         // mode 21->22, packet size
+    CCSDS_TRACE_FSM_PAYLOAD,        // mode 22->23, payload length
+    CCSDS_TRACE_FSM_PACKET,         // packet complete, apid and size
+    CCSDS_TRACE_FSM_LENGTH_ERROR,   // false lock, data length and maximum packet size
+    CCSDS_TRACE_FSM_CRC_ERROR,      // false lock, sent and computed CRC
+    CCSDS_TRACE_FSM_POOL_EXHAUSTED, // packet skipped, apid and size
+    CCSDS_TRACE_FSM_RESCAN,         // bytes of a rejected candidate queued for rescan
+    CCSDS_TRACE_FSM_EXPIRED,        // partial packet timed out, mode and bytes received
+    CCSDS_TRACE_FRAME_FECF_ERROR,   // frame dropped, sent and computed FECF
+    CCSDS_TRACE_FRAME_SYNC,         // ASM found after a loss (or at startup), bytes skipped
+    CCSDS_TRACE_FRAME_GAP,          // vcid and number of lost frames
+    CCSDS_TRACE_FRAME_ALIGN,        // vcid and First Header Pointer the state machine restarts at
+    CCSDS_TRACE_SEQ_DUPLICATE,      // apid and sequence count
+    CCSDS_TRACE_SEQ_GAP,            // apid and number of lost packets
+    CCSDS_TRACE_SEQ_JOINED,         // apid and size of the joined unit
+    CCSDS_TRACE_FORWARD_ERROR,      // datagrams which could not be sent
+    CCSDS_TRACE_FORWARD_ROUTES,     // new routing table in use, number of destinations
+    CCSDS_TRACE_EVENT_COUNT
+};
+
+struct ccsds_trace_entry
+{
+    uint32_t seq;       // index + 1 of the entry once it is complete, 0 while it is written
+    uint32_t time_us;   // low 32 bits of osal_time_us
+    uint32_t event;
+    uint32_t arg[2];
+};
+
+void ccsds_trace_record(uint32_t event, uint32_t arg0, uint32_t arg1);
+
+// print the entries recorded since the last dump, oldest first, returns the number printed
+// only one dump runs at a time, a concurrent call returns 0 at once
+unsigned int ccsds_trace_dump(void);
+
+// thread entry, dumps the ring every interval_ms (parameter casted from uintptr_t)
+// prints with osal_printf (a console line and 32 bit conversions only), 2 KiB of stack are enough
+void ccsds_trace_thread(void* parameter);
+
+#if CCSDS_TRACE_LEVEL >= CCSDS_TRACE_LEVEL_ERROR
+#define CCSDS_TRACE_ERROR(event, arg0, arg1)    ccsds_trace_record(event, arg0, arg1)
+#else
+#define CCSDS_TRACE_ERROR(event, arg0, arg1)    ((void)0)
+#endif
+#if CCSDS_TRACE_LEVEL >= CCSDS_TRACE_LEVEL_INFO
+#define CCSDS_TRACE_INFO(event, arg0, arg1)     ccsds_trace_record(event, arg0, arg1)
+#else
+#define CCSDS_TRACE_INFO(event, arg0, arg1)     ((void)0)
+#endif
+#if CCSDS_TRACE_LEVEL >= CCSDS_TRACE_LEVEL_DEBUG
+#define CCSDS_TRACE_DEBUG(event, arg0, arg1)    ccsds_trace_record(event, arg0, arg1)
+#else
+#define CCSDS_TRACE_DEBUG(event, arg0, arg1)    ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,720 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     several sources on pinned worker threads, shared egress thread
+ * 2026-10-17   Nico Maas     optional TM Transfer Frame input
+ * 2026-10-17   Nico Maas     per-APID routing from a file, reloaded on SIGHUP
+ * 2026-10-17   Nico Maas     configuration file (-c), reloaded on SIGHUP without stopping the reassembly
+ * 2026-10-17   Nico Maas     a worker which cannot receive any more ends the process
+ */
+
+// Linux gateway: receives split CCSDS Space Packets via UDP, reassembles them with the
+// same core library as the RT-Thread application and forwards them to the target system
+//
+// every source (listen address and port) has a reassembly context of its own, so split streams never mix
+// the sources are spread over worker threads pinned to the CPUs, each worker waits with epoll for its
+// sources, receives with recvmmsg and reassembles with a packet pool of its own
+// completed packets travel through one lock-free queue per worker to the egress thread (main thread)
+// which owns the forwarding socket
+// with frame input (-F) every source gets a TM Transfer Frame input stage with a state machine per virtual channel
+// the egress thread routes every packet by its APID to one or more destinations, the routing rules are read
+// from a file (-r) which is read again on SIGHUP while the reassembly keeps running
+// so is the configuration file (-c): every worker takes a new configuration between two batches of datagrams,
+// packets which are partial at that moment finish under the configuration they started with
+
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ccsds_conf.h"
+#include "ccsds_config.h"
+#include "ccsds_crc16.h"
+#include "ccsds_forward.h"
+#include "ccsds_frame.h"
+#include "ccsds_fsm.h"
+#include "ccsds_metrics.h"
+#include "ccsds_queue.h"
+#include "ccsds_seq.h"
+#include "ccsds_trace.h"
+#include "osal.h"
+
+// largest UDP payload
+#define DATAGRAM_SIZE       65536
+#define MAX_SOURCES         16
+// datagrams taken from the socket with one recvmmsg call
+#define RECV_BATCH          32
+// batches taken from one ready socket before the other sources get their turn
+#define RECV_ROUNDS         8
+// packets waiting between a worker and the egress thread, must be a power of two
+#define EGRESS_RING_SIZE    1024
+#define SOCKET_RCVBUF       (4 * 1024 * 1024)
+// largest routing file
+#define ROUTE_FILE_SIZE     (64 * 1024)
+
+struct worker;
+
+// one listen socket with its own reassembly context
+struct source
+{
+    struct sockaddr_in addr;
+    int fd;
+    struct worker* worker;
+    struct ccsds_frame* frame;              // frame input stage, NULL for a plain packet stream
+    struct ccsds_fsm fsm[CCSDS_FRAME_VCS];  // plain packet stream: fsm[0], frame input: one per virtual channel
+    struct ccsds_seq seq;
+};
+
+struct worker
+{
+    unsigned int index;
+    struct source* sources[MAX_SOURCES];
+    unsigned int source_count;
+    struct ccsds_pool pool;
+    struct ccsds_metrics metrics;
+    struct ccsds_conf_reader conf;      // configuration of the state machines of the worker
+    struct ccsds_queue egress;          // completed packets for the egress thread
+    void* egress_ring[EGRESS_RING_SIZE];
+    uint8_t pushed;                     // packets were queued since the egress thread was woken up
+    uint8_t* datagrams;                 // RECV_BATCH receive buffers
+};
+
+// configuration and routing files given on the command line, read again on SIGHUP
+static const char* conf_path;
+static const char* route_path;
+static struct source sources[MAX_SOURCES];
+static unsigned int source_count;
+static struct worker* workers;
+static unsigned int worker_count;
+static int frame_input = FRAME_INPUT;
+
+// egress thread
+static osal_sem_t egress_sem;
+static struct ccsds_pool egress_pool;
+static struct ccsds_metrics egress_metrics;
+static struct ccsds_forward forward;
+static struct ccsds_metrics_publisher stats_publisher;
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-l [listen_ip:]port ...] [-t workers] [-c conf_file] [-d dest_ip] [-p dest_port] [-r route_file] [-m mtu] [-f flush_ms] [-F]\n", name);
+    fprintf(stderr, "  -c  INI configuration ([packet], [apids], [routes]) instead of the compiled-in one, read again on SIGHUP\n");
+    fprintf(stderr, "  -r  routing rules, one per line \"first[-last] ip:port [ip:port ...]\", '*' for all other APIDs,\n"
+                    "      read again on SIGHUP (default: ROUTE_CONFIG of ccsds_config.h, -d/-p for all other APIDs)\n");
+    fprintf(stderr, "  -F  TM Transfer Frame input as configured in ccsds_config.h\n");
+}
+
+// "[ip:]port" into a socket address
+static int parse_source(const char* spec, struct sockaddr_in* addr)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_ANY);
+    const char* port = strrchr(spec, ':');
+    if (port != NULL)
+    {
+        char ip[INET_ADDRSTRLEN];
+        size_t len = port - spec;
+        if (len >= sizeof(ip))
+        {
+            return -1;
+        }
+        memcpy(ip, spec, len);
+        ip[len] = '\0';
+        if (inet_pton(AF_INET, ip, &addr->sin_addr) != 1)
+        {
+            return -1;
+        }
+        port++;
+    }
+    else
+    {
+        port = spec;
+    }
+    int value = atoi(port);
+    if (value <= 0 || value > 65535)
+    {
+        return -1;
+    }
+    addr->sin_port = htons((uint16_t)value);
+    return 0;
+}
+
+static int open_source(struct source* source)
+{
+    source->fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (source->fd < 0)
+    {
+        perror("socket");
+        return -1;
+    }
+    // bursts of the ground station must not overflow the socket while the worker is busy
+    int rcvbuf = SOCKET_RCVBUF;
+    setsockopt(source->fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    if (bind(source->fd, (struct sockaddr*)&source->addr, sizeof(source->addr)) != 0)
+    {
+        perror("bind");
+        close(source->fd);
+        return -1;
+    }
+    return 0;
+}
+
+// end of the reassembly of a worker, ccsds_packet_cb compatible
+static void worker_packet(void* arg, struct ccsds_buffer* packet)
+{
+    struct worker* worker = arg;
+    if (ccsds_queue_push(&worker->egress, packet) != 0)
+    {
+        worker->metrics.egress_drops++;
+        ccsds_buffer_free(packet);
+        return;
+    }
+    worker->pushed = 1;
+}
+
+// a span of a source into its frame input stage or straight into its state machine
+static void source_feed(struct source* source, const uint8_t* data, size_t len, uint64_t rx_time_us)
+{
+    if (source->frame != NULL)
+    {
+        source->frame->rx_time_us = rx_time_us;
+        ccsds_frame_feed(source->frame, data, len);
+        ccsds_frame_end(source->frame);
+    }
+    else
+    {
+        source->fsm[0].rx_time_us = rx_time_us;
+        ccsds_fsm_feed(&source->fsm[0], data, len);
+    }
+}
+
+static int32_t source_timeout(const struct source* source, uint64_t now_us)
+{
+    return (source->frame != NULL) ? ccsds_frame_timeout(source->frame, now_us) : ccsds_fsm_timeout(&source->fsm[0], now_us);
+}
+
+static void source_poll(struct source* source, uint64_t now_us)
+{
+    if (source->frame != NULL)
+    {
+        ccsds_frame_poll(source->frame, now_us);
+    }
+    else
+    {
+        ccsds_fsm_poll(&source->fsm[0], now_us);
+    }
+}
+
+// a state machine of the source still finishes a packet under the previous configuration
+static int source_switching(const struct source* source)
+{
+    for (unsigned int i = 0; i < CCSDS_FRAME_VCS; i++)
+    {
+        if (source->fsm[i].replay != NULL && ccsds_fsm_switching(&source->fsm[i]))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void source_set_apids(struct source* source, const struct ccsds_apid_table* apids)
+{
+    // packets the state machines still complete under the previous configuration carry it to the sequence stage
+    ccsds_seq_set_apids(&source->seq, apids);
+    for (unsigned int i = 0; i < CCSDS_FRAME_VCS; i++)
+    {
+        // only the state machines which have been set up
+        if (source->fsm[i].replay != NULL)
+        {
+            ccsds_fsm_set_apids(&source->fsm[i], apids);
+        }
+    }
+}
+
+// reassembly context of a source, a state machine per configured virtual channel with frame input
+static int source_init(struct source* source, struct worker* worker)
+{
+    const struct ccsds_apid_table* apids = &worker->conf.conf->table;
+    if (ccsds_seq_init(&source->seq, apids, &worker->pool, &worker->metrics, JOIN_SEGMENTS, worker_packet, worker) != 0)
+    {
+        return -1;
+    }
+    if (!frame_input)
+    {
+        if (ccsds_fsm_init(&source->fsm[0], apids, &worker->pool, &worker->metrics, ccsds_seq_packet, &source->seq) != 0)
+        {
+            return -1;
+        }
+        ccsds_fsm_set_timeout(&source->fsm[0], REASSEMBLY_TIMEOUT_MS, REASSEMBLY_TIMEOUT_RESCAN);
+        return 0;
+    }
+    source->frame = malloc(sizeof(struct ccsds_frame));
+    if (source->frame == NULL || ccsds_frame_init(source->frame, &FRAME_CONFIG, &worker->metrics) != 0)
+    {
+        return -1;
+    }
+    for (unsigned int i = 0; i < CCSDS_FRAME_VCS; i++)
+    {
+        if ((FRAME_VCIDS & (1 << i)) == 0)
+        {
+            continue;
+        }
+        if (ccsds_fsm_init(&source->fsm[i], apids, &worker->pool, &worker->metrics, ccsds_seq_packet, &source->seq) != 0)
+        {
+            return -1;
+        }
+        // an aligned state machine has no false locks to rescan
+        ccsds_fsm_set_timeout(&source->fsm[i], REASSEMBLY_TIMEOUT_MS, 0);
+        ccsds_frame_attach(source->frame, i, &source->fsm[i]);
+    }
+    return 0;
+}
+
+// take a batch of datagrams out of the socket of a source and feed them one by one
+static int worker_receive(struct worker* worker, struct source* source, int flags)
+{
+    struct mmsghdr msgs[RECV_BATCH];
+    struct iovec iov[RECV_BATCH];
+    memset(msgs, 0, sizeof(msgs));
+    for (unsigned int i = 0; i < RECV_BATCH; i++)
+    {
+        iov[i].iov_base = &worker->datagrams[i * DATAGRAM_SIZE];
+        iov[i].iov_len = DATAGRAM_SIZE;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int count = recvmmsg(source->fd, msgs, RECV_BATCH, flags, NULL);
+    if (count < 0)
+    {
+        if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            return 0;
+        }
+        worker->metrics.rx_errors++;
+        // out of kernel memory: the datagrams are lost, but the socket still works
+        return (errno == ENOMEM || errno == ENOBUFS) ? 0 : -1;
+    }
+    uint64_t rx_time_us = osal_time_us();
+    for (int i = 0; i < count; i++)
+    {
+        worker->metrics.datagrams++;
+        worker->metrics.rx_bytes += msgs[i].msg_len;
+        // every datagram is fed as one span
+        source_feed(source, iov[i].iov_base, msgs[i].msg_len, rx_time_us);
+    }
+    return count;
+}
+
+// take a configuration published by the reload thread, partial packets finish under the one they started with
+// and the previous configuration is released once they are done
+static void worker_config(struct worker* worker)
+{
+    if (worker->conf.old != NULL)
+    {
+        int switching = 0;
+        for (unsigned int i = 0; i < worker->source_count; i++)
+        {
+            switching |= source_switching(worker->sources[i]);
+        }
+        if (!switching)
+        {
+            ccsds_conf_reader_retire(&worker->conf);
+        }
+    }
+    struct ccsds_conf* conf = ccsds_conf_reader_update(&worker->conf);
+    if (conf != NULL)
+    {
+        for (unsigned int i = 0; i < worker->source_count; i++)
+        {
+            source_set_apids(worker->sources[i], &conf->table);
+        }
+    }
+}
+
+// one wake-up of the egress thread per batch, not per packet
+static void worker_wake_egress(struct worker* worker)
+{
+    if (worker->pushed)
+    {
+        worker->pushed = 0;
+        osal_sem_give(egress_sem);
+    }
+}
+
+// a worker which cannot wait or receive any more would leave its sources dead while the process runs on,
+// end the process so that it is noticed (and restarted by whatever supervises it)
+static void worker_fatal(const struct worker* worker, const char* call)
+{
+    osal_printf("Worker %u: %s failed: %s\n", worker->index, call, strerror(errno));
+    exit(EXIT_FAILURE);
+}
+
+static void worker_thread(void* parameter)
+{
+    struct worker* worker = parameter;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > 1)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(worker->index % cpus, &set);
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+    int epoll_fd = epoll_create1(0);
+    if (epoll_fd < 0)
+    {
+        worker_fatal(worker, "epoll_create1");
+    }
+    for (unsigned int i = 0; i < worker->source_count; i++)
+    {
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = worker->sources[i] };
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, worker->sources[i]->fd, &event) != 0)
+        {
+            worker_fatal(worker, "epoll_ctl");
+        }
+    }
+    while (1)
+    {
+        // wait for datagrams, at most until the first partial packet of the sources expires
+        uint64_t now = osal_time_us();
+        int32_t timeout = OSAL_WAIT_FOREVER;
+        for (unsigned int i = 0; i < worker->source_count; i++)
+        {
+            int32_t timeout_ms = source_timeout(worker->sources[i], now);
+            if (timeout_ms != OSAL_WAIT_FOREVER && (timeout == OSAL_WAIT_FOREVER || timeout_ms < timeout))
+            {
+                timeout = timeout_ms;
+            }
+        }
+        struct epoll_event events[MAX_SOURCES];
+        int ready = epoll_wait(epoll_fd, events, MAX_SOURCES, timeout);
+        if (ready < 0 && errno != EINTR)
+        {
+            worker_fatal(worker, "epoll_wait");
+        }
+        // a new configuration is only checked between batches, one load and compare without a lock
+        if (ccsds_conf_reader_changed(&worker->conf) || worker->conf.old != NULL)
+        {
+            worker_config(worker);
+        }
+        for (int i = 0; i < ready; i++)
+        {
+            // take everything waiting in the socket: batches until a short one, which leaves it empty,
+            // at most RECV_ROUNDS of them, epoll reports a socket with datagrams left again
+            int count;
+            unsigned int rounds = 0;
+            do
+            {
+                count = worker_receive(worker, events[i].data.ptr, MSG_DONTWAIT);
+                if (count < 0)
+                {
+                    worker_fatal(worker, "recvmmsg");
+                }
+                worker_wake_egress(worker);
+            } while (count == RECV_BATCH && ++rounds < RECV_ROUNDS);
+        }
+        now = osal_time_us();
+        for (unsigned int i = 0; i < worker->source_count; i++)
+        {
+            source_poll(worker->sources[i], now);
+        }
+        // packets found by the rescan of expired partial packets
+        worker_wake_egress(worker);
+    }
+}
+
+// read and compile the routing rules of a file, NULL if it cannot be read or has an error
+static struct ccsds_route_table* load_routes(const char* path)
+{
+    char* text = osal_file_read(path, ROUTE_FILE_SIZE);
+    struct ccsds_route_table* routes = (text != NULL) ? ccsds_route_table_parse(text) : NULL;
+    osal_free(text);
+    if (routes == NULL)
+    {
+        osal_printf("Failed to load the routing rules of %s\n", path);
+    }
+    return routes;
+}
+
+// hand a routing table to the egress thread
+static void publish_routes(struct ccsds_route_table* routes)
+{
+    ccsds_route_table_print(routes);
+    ccsds_forward_set_routes(&forward, routes);
+    // the egress thread may wait forever, it takes the table over when it wakes up
+    osal_sem_give(egress_sem);
+}
+
+// waits for SIGHUP and reads the configuration file and the routing rules again,
+// the previous ones stay in use if a file has an error
+static void reload_thread(void* parameter)
+{
+    (void)parameter;
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGHUP);
+    while (1)
+    {
+        int sig;
+        if (sigwait(&set, &sig) != 0)
+        {
+            continue;
+        }
+        if (conf_path != NULL)
+        {
+            // settings the file leaves out stay as they are
+            struct ccsds_conf* current = ccsds_conf_acquire();
+            struct ccsds_conf* conf = ccsds_conf_load(conf_path, current);
+            ccsds_conf_release(current);
+            if (conf == NULL)
+            {
+                osal_printf("Failed to load the configuration %s\n", conf_path);
+            }
+            else
+            {
+                osal_printf("Configuration %s reloaded:\n", conf_path);
+                ccsds_conf_print(conf);
+                // -r takes precedence over the routing rules of the configuration file
+                if (conf->routes != NULL && route_path == NULL)
+                {
+                    publish_routes(conf->routes);
+                    conf->routes = NULL;
+                }
+                // the workers switch to it between two batches of datagrams
+                ccsds_conf_publish(conf);
+            }
+        }
+        if (route_path != NULL)
+        {
+            struct ccsds_route_table* routes = load_routes(route_path);
+            if (routes != NULL)
+            {
+                osal_printf("Routing rules of %s reloaded:\n", route_path);
+                publish_routes(routes);
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* dest_ip = DEST_IP_ADDR;
+    uint16_t dest_port = DEST_UDP_PORT;
+    uint32_t mtu = FORWARD_MTU;
+    uint32_t flush_ms = FORWARD_FLUSH_MS;
+    unsigned int threads = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "l:t:c:d:p:r:m:f:Fh")) != -1)
+    {
+        switch (opt)
+        {
+        case 'l':
+            if (source_count == MAX_SOURCES || parse_source(optarg, &sources[source_count].addr) != 0)
+            {
+                fprintf(stderr, "invalid or too many sources: %s\n", optarg);
+                return 1;
+            }
+            source_count++;
+            break;
+        case 't':
+            threads = (unsigned int)atoi(optarg);
+            break;
+        case 'c':
+            conf_path = optarg;
+            break;
+        case 'd':
+            dest_ip = optarg;
+            break;
+        case 'p':
+            dest_port = (uint16_t)atoi(optarg);
+            break;
+        case 'r':
+            route_path = optarg;
+            break;
+        case 'm':
+            mtu = (uint32_t)atoi(optarg);
+            break;
+        case 'f':
+            flush_ms = (uint32_t)atoi(optarg);
+            break;
+        case 'F':
+            frame_input = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return (opt == 'h') ? 0 : 1;
+        }
+    }
+    if (conf_path != NULL || route_path != NULL)
+    {
+        // SIGHUP is only taken by the reload thread, all threads created later inherit the blocked mask
+        sigset_t hup;
+        sigemptyset(&hup);
+        sigaddset(&hup, SIGHUP);
+        pthread_sigmask(SIG_BLOCK, &hup, NULL);
+    }
+    if (source_count == 0)
+    {
+        char spec[8];
+        snprintf(spec, sizeof(spec), "%d", SERVER_UDP_PORT);
+        parse_source(spec, &sources[source_count++].addr);
+    }
+    // by default one worker per source, but not more than CPUs
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    worker_count = (threads != 0) ? threads : source_count;
+    if (threads == 0 && cpus > 0 && worker_count > (unsigned int)cpus)
+    {
+        worker_count = (unsigned int)cpus;
+    }
+    if (worker_count > source_count)
+    {
+        worker_count = source_count;
+    }
+
+    osal_printf("CCSDS-TM-FSM\n");
+    struct ccsds_conf* conf = (conf_path != NULL) ? ccsds_conf_load(conf_path, NULL) :
+                              ccsds_conf_create(PACKET_VERSION_NUMBER, PACKET_TYPE, APID_CONFIG, APID_CONFIG_COUNT);
+    if (conf == NULL)
+    {
+        osal_printf("Invalid configuration %s\n", (conf_path != NULL) ? conf_path : "");
+        return 1;
+    }
+    osal_printf("Configuration: %s\n", (conf_path != NULL) ? conf_path : "compiled-in");
+    ccsds_conf_print(conf);
+    // the routing rules of -r, otherwise the ones of the configuration file, otherwise ROUTE_CONFIG
+    struct ccsds_route_table* routes = conf->routes;
+    conf->routes = NULL;
+    if (route_path != NULL || routes == NULL)
+    {
+        if (routes != NULL)
+        {
+            ccsds_route_table_free(routes);
+        }
+        routes = (route_path != NULL) ? load_routes(route_path) :
+                 ccsds_route_table_create(ROUTE_CONFIG, ROUTE_CONFIG_COUNT, dest_ip, dest_port);
+    }
+    if (routes == NULL)
+    {
+        osal_printf("Invalid routing configuration\n");
+        return 1;
+    }
+    ccsds_conf_publish(conf);
+
+    workers = calloc(worker_count, sizeof(struct worker));
+    if (workers == NULL)
+    {
+        osal_printf("Failed to allocate workers\n");
+        return 1;
+    }
+    for (unsigned int i = 0; i < worker_count; i++)
+    {
+        struct worker* worker = &workers[i];
+        worker->index = i;
+        worker->datagrams = malloc(RECV_BATCH * DATAGRAM_SIZE);
+        if (worker->datagrams == NULL ||
+            ccsds_pool_init(&worker->pool, POOL_CONFIG, POOL_CONFIG_COUNT) != 0 ||
+            ccsds_metrics_init(&worker->metrics, "worker", CCSDS_APID_SLOTS) != 0 ||
+            ccsds_queue_init(&worker->egress, NULL, worker->egress_ring, EGRESS_RING_SIZE) != 0)
+        {
+            osal_printf("Failed to allocate worker buffers\n");
+            return 1;
+        }
+        ccsds_metrics_register(&worker->metrics);
+        ccsds_conf_reader_init(&worker->conf);
+    }
+    for (unsigned int i = 0; i < source_count; i++)
+    {
+        struct source* source = &sources[i];
+        struct worker* worker = &workers[i % worker_count];
+        if (open_source(source) != 0)
+        {
+            return 1;
+        }
+        source->worker = worker;
+        worker->sources[worker->source_count++] = source;
+        if (source_init(source, worker) != 0)
+        {
+            osal_printf("Failed to allocate state machine buffers\n");
+            return 1;
+        }
+        char ip[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &source->addr.sin_addr, ip, sizeof(ip));
+        osal_printf("UDP Server: %s, UDP Port: %d, worker %u\n", ip, ntohs(source->addr.sin_port), worker->index);
+    }
+    if (frame_input)
+    {
+        osal_printf("TM Transfer Frames of %d bytes, virtual channels 0x%02x\n", FRAME_CONFIG.length, FRAME_VCIDS);
+    }
+    osal_printf("Routing:\n");
+    ccsds_route_table_print(routes);
+
+    egress_sem = osal_sem_create("egress", 0);
+    if (egress_sem == NULL ||
+        ccsds_pool_init(&egress_pool, POOL_CONFIG, POOL_CONFIG_COUNT) != 0 ||
+        ccsds_metrics_init(&egress_metrics, "egress", 0) != 0)
+    {
+        osal_printf("Failed to allocate egress buffers\n");
+        return 1;
+    }
+    ccsds_metrics_register(&egress_metrics);
+    if (ccsds_forward_init(&forward, &egress_pool, &egress_metrics, routes, mtu, flush_ms) != 0)
+    {
+        osal_printf("Failed to open the forwarding socket\n");
+        return 1;
+    }
+    osal_printf("CRC16 implementation: %s\n", ccsds_crc16_name());
+    stats_publisher.dest_ip = dest_ip;
+    stats_publisher.dest_port = STATS_UDP_PORT;
+    stats_publisher.interval_ms = STATS_INTERVAL_MS;
+    if (STATS_INTERVAL_MS > 0 && osal_thread_create("stats", ccsds_metrics_thread, &stats_publisher, 0, 0) != 0)
+    {
+        osal_printf("Failed to create stats thread\n");
+    }
+    if (TRACE_DRAIN_MS > 0 && osal_thread_create("trace", ccsds_trace_thread, (void*)(uintptr_t)TRACE_DRAIN_MS, 0, 0) != 0)
+    {
+        osal_printf("Failed to create trace thread\n");
+    }
+    if ((conf_path != NULL || route_path != NULL) && osal_thread_create("reload", reload_thread, NULL, 0, 0) != 0)
+    {
+        osal_printf("Failed to create reload thread\n");
+    }
+    for (unsigned int i = 0; i < worker_count; i++)
+    {
+        if (osal_thread_create("worker", worker_thread, &workers[i], 0, 0) != 0)
+        {
+            osal_printf("Failed to create worker thread\n");
+            return 1;
+        }
+    }
+    osal_printf("Finite State machine started, %u worker(s)\n", worker_count);
+
+    // egress: collect the packets of all workers and forward them in batches
+    while (1)
+    {
+        // wait for packets, at most until a partly filled aggregate is due
+        osal_sem_take(egress_sem, ccsds_forward_timeout(&forward, osal_time_us()));
+        for (unsigned int i = 0; i < worker_count; i++)
+        {
+            struct ccsds_buffer* packet;
+            while ((packet = ccsds_queue_pop(&workers[i].egress, 0)) != NULL)
+            {
+                ccsds_forward_packet(&forward, packet);
+            }
+        }
+        ccsds_forward_flush(&forward, osal_time_us());
+    }
+    return 1;
+}
@@ -0,0 +1,792 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     TM Transfer Frame input
+ * 2026-10-17   Nico Maas     sequence counters per APID
+ */
+
+// Replay and benchmark tool: feeds captured or generated datagrams through the same reassembly
+// core as the gateway (state machine and sequence stage) and reports throughput and latency
+//
+// captures are either pcap files (Ethernet, raw IPv4 or Linux cooked, UDP to the listen port) or
+// datagram logs: the magic "CCSDSLOG" followed by records of a 64 bit timestamp in us,
+// a 32 bit length (both little endian) and the datagram itself
+// with -F the datagrams are TM Transfer Frames as configured in ccsds_config.h, generated workloads are
+// wrapped into frames of the first virtual channel of FRAME_VCIDS
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ccsds_config.h"
+#include "ccsds_crc16.h"
+#include "ccsds_frame.h"
+#include "ccsds_fsm.h"
+#include "ccsds_metrics.h"
+#include "ccsds_seq.h"
+
+#define LOG_MAGIC           "CCSDSLOG"
+#define LOG_MAGIC_SIZE      8
+#define LOG_RECORD_SIZE     12
+
+// datagram size of the generated workloads, UDP over Ethernet without IP fragmentation
+#define GEN_DATAGRAM_SIZE   1472
+
+// latency histogram in ns, 16 linear sub-buckets per power of two (about 6 % resolution)
+#define LAT_SUB_BITS        4
+#define LAT_SUB_BUCKETS     (1 << LAT_SUB_BITS)
+#define LAT_BUCKETS         ((64 - LAT_SUB_BITS + 1) * LAT_SUB_BUCKETS)
+
+struct datagram
+{
+    const uint8_t* data;
+    uint32_t len;
+    uint64_t time_us;   // capture time, relative pacing only
+};
+
+struct capture
+{
+    struct datagram* datagrams;
+    size_t count;
+    size_t capacity;
+    uint64_t bytes;
+    uint8_t* generated;     // backing store of a generated workload
+    size_t generated_len;
+    uint32_t expected;      // packets a generated workload contains, 0 if unknown
+};
+
+static struct ccsds_apid_table apid_table;
+static struct ccsds_pool pool;
+static struct ccsds_fsm fsm;
+static struct ccsds_seq seq;
+static struct ccsds_metrics metrics;
+static int frame_input;
+static struct ccsds_frame frame;
+static struct ccsds_fsm vc_fsm[CCSDS_FRAME_VCS];
+
+static uint64_t feed_start_ns;
+static uint64_t packets;
+static uint64_t packet_bytes;
+static uint64_t latency[LAT_BUCKETS];
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static unsigned int latency_bucket(uint64_t ns)
+{
+    if (ns < LAT_SUB_BUCKETS)
+    {
+        return (unsigned int)ns;
+    }
+    unsigned int msb = 63 - __builtin_clzll(ns);
+    unsigned int shift = msb - LAT_SUB_BITS;
+    return (shift + 1) * LAT_SUB_BUCKETS + (unsigned int)((ns >> shift) & (LAT_SUB_BUCKETS - 1));
+}
+
+// upper bound of a bucket in ns
+static uint64_t latency_bound(unsigned int bucket)
+{
+    if (bucket < LAT_SUB_BUCKETS)
+    {
+        return bucket;
+    }
+    unsigned int shift = bucket / LAT_SUB_BUCKETS - 1;
+    uint64_t sub = bucket % LAT_SUB_BUCKETS;
+    return ((LAT_SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+static uint64_t latency_percentile(double fraction)
+{
+    uint64_t total = 0;
+    for (unsigned int i = 0; i < LAT_BUCKETS; i++)
+    {
+        total += latency[i];
+    }
+    uint64_t rank = (uint64_t)(total * fraction + 0.5);
+    uint64_t seen = 0;
+    for (unsigned int i = 0; i < LAT_BUCKETS; i++)
+    {
+        seen += latency[i];
+        if (seen >= rank && seen > 0)
+        {
+            return latency_bound(i);
+        }
+    }
+    return 0;
+}
+
+// end of the pipeline instead of forwarding: count, measure and release the packet
+// latency is the time from the start of feeding the datagram which completed the packet
+static void replay_packet(void* arg, struct ccsds_buffer* packet)
+{
+    (void)arg;
+    packets++;
+    packet_bytes += packet->length;
+    latency[latency_bucket(now_ns() - feed_start_ns)]++;
+    ccsds_buffer_free(packet);
+}
+
+static int capture_add(struct capture* capture, const uint8_t* data, uint32_t len, uint64_t time_us)
+{
+    if (capture->count == capture->capacity)
+    {
+        size_t capacity = capture->capacity ? capture->capacity * 2 : 1024;
+        struct datagram* datagrams = realloc(capture->datagrams, capacity * sizeof(*datagrams));
+        if (datagrams == NULL)
+        {
+            return -1;
+        }
+        capture->datagrams = datagrams;
+        capture->capacity = capacity;
+    }
+    capture->datagrams[capture->count++] = (struct datagram){ data, len, time_us };
+    capture->bytes += len;
+    return 0;
+}
+
+static uint32_t rd16be(const uint8_t* p) { return (uint32_t)p[0] << 8 | p[1]; }
+static uint32_t rd32le(const uint8_t* p) { return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24; }
+static uint32_t rd32be(const uint8_t* p) { return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3]; }
+static uint64_t rd64le(const uint8_t* p) { return (uint64_t)rd32le(&p[4]) << 32 | rd32le(p); }
+
+// UDP payload of an IPv4 packet, NULL if it is no unfragmented UDP datagram to port (0: any port)
+static const uint8_t* pcap_udp(const uint8_t* ip, size_t len, uint16_t port, uint32_t* payload_len)
+{
+    if (len < 20 || (ip[0] >> 4) != 4 || ip[9] != 17)
+    {
+        return NULL;
+    }
+    size_t ihl = (ip[0] & 0x0F) * 4;
+    // fragments would need IP reassembly, they are skipped
+    if ((rd16be(&ip[6]) & 0x3FFF) != 0 || len < ihl + 8)
+    {
+        return NULL;
+    }
+    const uint8_t* udp = &ip[ihl];
+    if (port != 0 && rd16be(&udp[2]) != port)
+    {
+        return NULL;
+    }
+    uint32_t udp_len = rd16be(&udp[4]);
+    if (udp_len < 8)
+    {
+        return NULL;
+    }
+    *payload_len = udp_len - 8;
+    if (*payload_len > len - ihl - 8)
+    {
+        *payload_len = len - ihl - 8;   // truncated by the snap length
+    }
+    return &udp[8];
+}
+
+static int load_pcap(struct capture* capture, const uint8_t* file, size_t size, uint16_t port)
+{
+    uint32_t magic = rd32le(file);
+    int swapped = (magic == 0xD4C3B2A1 || magic == 0x4D3CB2A1);
+    uint32_t (*rd32)(const uint8_t*) = swapped ? rd32be : rd32le;
+    int nano = (magic == 0xA1B23C4D || magic == 0x4D3CB2A1);
+    uint32_t linktype = rd32(&file[20]) & 0xFFFF;
+    size_t pos = 24;
+    while (pos + 16 <= size)
+    {
+        uint64_t time_us = (uint64_t)rd32(&file[pos]) * 1000000 + rd32(&file[pos + 4]) / (nano ? 1000 : 1);
+        uint32_t caplen = rd32(&file[pos + 8]);
+        pos += 16;
+        if (caplen > size - pos)
+        {
+            break;
+        }
+        const uint8_t* frame = &file[pos];
+        pos += caplen;
+        size_t offset;
+        uint32_t ethertype;
+        if (linktype == 1)          // Ethernet
+        {
+            offset = 14;
+            ethertype = (caplen >= 14) ? rd16be(&frame[12]) : 0;
+            if (ethertype == 0x8100 && caplen >= 18)    // VLAN tag
+            {
+                offset = 18;
+                ethertype = rd16be(&frame[16]);
+            }
+        }
+        else if (linktype == 113)   // Linux cooked capture
+        {
+            offset = 16;
+            ethertype = (caplen >= 16) ? rd16be(&frame[14]) : 0;
+        }
+        else if (linktype == 276)   // Linux cooked capture v2
+        {
+            offset = 20;
+            ethertype = (caplen >= 20) ? rd16be(&frame[0]) : 0;
+        }
+        else if (linktype == 101 || linktype == 12)     // raw IP
+        {
+            offset = 0;
+            ethertype = 0x0800;
+        }
+        else
+        {
+            fprintf(stderr, "unsupported pcap link type %u\n", linktype);
+            return -1;
+        }
+        uint32_t len;
+        const uint8_t* payload = (ethertype == 0x0800 && caplen >= offset) ? pcap_udp(&frame[offset], caplen - offset, port, &len) : NULL;
+        if (payload != NULL && capture_add(capture, payload, len, time_us) != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int load_log(struct capture* capture, const uint8_t* file, size_t size)
+{
+    size_t pos = LOG_MAGIC_SIZE;
+    while (pos + LOG_RECORD_SIZE <= size)
+    {
+        uint64_t time_us = rd64le(&file[pos]);
+        uint32_t len = rd32le(&file[pos + 8]);
+        pos += LOG_RECORD_SIZE;
+        if (len > size - pos)
+        {
+            fprintf(stderr, "truncated datagram log\n");
+            return -1;
+        }
+        if (capture_add(capture, &file[pos], len, time_us) != 0)
+        {
+            return -1;
+        }
+        pos += len;
+    }
+    return 0;
+}
+
+static int load_file(struct capture* capture, const char* name, uint16_t port)
+{
+    int fd = open(name, O_RDONLY);
+    if (fd < 0)
+    {
+        perror(name);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 24)
+    {
+        fprintf(stderr, "%s: not a capture\n", name);
+        close(fd);
+        return -1;
+    }
+    const uint8_t* file = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (file == MAP_FAILED)
+    {
+        perror("mmap");
+        return -1;
+    }
+    madvise((void*)file, st.st_size, MADV_WILLNEED);
+    uint32_t magic = rd32le(file);
+    if (memcmp(file, LOG_MAGIC, LOG_MAGIC_SIZE) == 0)
+    {
+        return load_log(capture, file, st.st_size);
+    }
+    if (magic == 0xA1B2C3D4 || magic == 0xD4C3B2A1 || magic == 0xA1B23C4D || magic == 0x4D3CB2A1)
+    {
+        return load_pcap(capture, file, st.st_size, port);
+    }
+    fprintf(stderr, "%s: unknown capture format\n", name);
+    return -1;
+}
+
+// generated workloads
+
+struct generator
+{
+    uint8_t* stream;
+    size_t len;
+    size_t size;
+    uint64_t rng;
+    uint32_t packets;
+    uint16_t counts[2048];  // next sequence count per APID
+};
+
+static uint32_t gen_random(struct generator* gen)
+{
+    // xorshift64*
+    gen->rng ^= gen->rng >> 12;
+    gen->rng ^= gen->rng << 25;
+    gen->rng ^= gen->rng >> 27;
+    return (uint32_t)((gen->rng * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+static int gen_reserve(struct generator* gen, size_t len)
+{
+    if (gen->len + len > gen->size)
+    {
+        size_t size = (gen->size ? gen->size * 2 : 1 << 20) + len;
+        uint8_t* stream = realloc(gen->stream, size);
+        if (stream == NULL)
+        {
+            return -1;
+        }
+        gen->stream = stream;
+        gen->size = size;
+    }
+    return 0;
+}
+
+// append one unsegmented packet of the given total size (incl. header and CRC) to the stream
+static int gen_packet(struct generator* gen, const struct ccsds_apid_config* config, uint32_t size)
+{
+    uint32_t crc_length = config->crc ? 2 : 0;
+    if (size < CCSDS_PRIMARY_HEADER_SIZE + crc_length + 1)
+    {
+        size = CCSDS_PRIMARY_HEADER_SIZE + crc_length + 1;
+    }
+    if (gen_reserve(gen, size) != 0)
+    {
+        return -1;
+    }
+    uint8_t* p = &gen->stream[gen->len];
+    uint16_t word = ccsds_syncword(PACKET_VERSION_NUMBER, PACKET_TYPE, config->secondary_header, config->apid);
+    uint16_t count = gen->counts[config->apid];
+    gen->counts[config->apid] = (count + 1) & 0x3FFF;
+    uint32_t data_length = size - CCSDS_PRIMARY_HEADER_SIZE - 1;
+    p[0] = word >> 8;
+    p[1] = word & 0xFF;
+    p[2] = CCSDS_SEQ_UNSEGMENTED << 6 | count >> 8;
+    p[3] = count & 0xFF;
+    p[4] = data_length >> 8;
+    p[5] = data_length & 0xFF;
+    for (uint32_t i = CCSDS_PRIMARY_HEADER_SIZE; i < size - crc_length; i++)
+    {
+        p[i] = gen_random(gen);
+    }
+    if (config->crc)
+    {
+        uint16_t crc = crc16sum(p, size - 2, CCSDS_CRC16_INIT);
+        p[size - 2] = crc >> 8;
+        p[size - 1] = crc & 0xFF;
+    }
+    gen->len += size;
+    gen->packets++;
+    return 0;
+}
+
+// largest packet the configuration of an APID and the pool accept
+static uint32_t gen_max_size(const struct ccsds_apid_config* config)
+{
+    uint32_t max_size = ccsds_pool_max_size(&pool);
+    if (config->max_length != 0 && config->max_length < max_size)
+    {
+        max_size = config->max_length;
+    }
+    return max_size;
+}
+
+static const struct ccsds_apid_config* gen_apid(struct generator* gen, int mixed)
+{
+    return &APID_CONFIG[mixed ? gen_random(gen) % APID_CONFIG_COUNT : 0];
+}
+
+// size of the frame including the ASM
+static uint32_t gen_frame_size(void)
+{
+    return (FRAME_CONFIG.asm_sync ? CCSDS_FRAME_ASM_SIZE : 0) + FRAME_CONFIG.length;
+}
+
+// append one frame with the given First Header Pointer and packet zone, the rest of the zone is zero
+static void gen_frame(uint8_t* out, uint8_t vc_count, uint16_t fhp, const uint8_t* zone, uint32_t len)
+{
+    uint32_t length = FRAME_CONFIG.length;
+    uint32_t zone_size = length - CCSDS_FRAME_PRIMARY_HEADER_SIZE - (FRAME_CONFIG.fecf ? CCSDS_FRAME_FECF_SIZE : 0);
+    unsigned int scid = (FRAME_CONFIG.scid >= 0) ? FRAME_CONFIG.scid : 0;
+    unsigned int vcid = __builtin_ctz(FRAME_VCIDS | 0x80);
+    if (FRAME_CONFIG.asm_sync)
+    {
+        out[0] = CCSDS_FRAME_ASM >> 24;
+        out[1] = (CCSDS_FRAME_ASM >> 16) & 0xFF;
+        out[2] = (CCSDS_FRAME_ASM >> 8) & 0xFF;
+        out[3] = CCSDS_FRAME_ASM & 0xFF;
+        out += CCSDS_FRAME_ASM_SIZE;
+    }
+    uint16_t id = scid << 4 | vcid << 1;
+    out[0] = id >> 8;
+    out[1] = id & 0xFF;
+    out[2] = vc_count;
+    out[3] = vc_count;
+    out[4] = fhp >> 8;
+    out[5] = fhp & 0xFF;
+    // an idle frame has no packet zone to copy (zone NULL)
+    if (len > 0)
+    {
+        memcpy(&out[CCSDS_FRAME_PRIMARY_HEADER_SIZE], zone, len);
+    }
+    memset(&out[CCSDS_FRAME_PRIMARY_HEADER_SIZE + len], 0, zone_size - len);
+    if (FRAME_CONFIG.fecf)
+    {
+        uint16_t crc = crc16sum(out, length - 2, CCSDS_CRC16_INIT);
+        out[length - 2] = crc >> 8;
+        out[length - 1] = crc & 0xFF;
+    }
+}
+
+// wrap the packet stream into frames, idle: idle frames between them
+static int gen_frames(struct generator* gen, int idle)
+{
+    uint32_t zone_size = FRAME_CONFIG.length - CCSDS_FRAME_PRIMARY_HEADER_SIZE - (FRAME_CONFIG.fecf ? CCSDS_FRAME_FECF_SIZE : 0);
+    uint32_t frame_size = gen_frame_size();
+    size_t capacity = (gen->len / zone_size + 1) * (idle ? 2 : 1) * frame_size;
+    uint8_t* frames = malloc(capacity);
+    if (frames == NULL)
+    {
+        return -1;
+    }
+    size_t len = 0;
+    size_t next_packet = 0;
+    uint8_t vc_count = 0;
+    for (size_t pos = 0; pos < gen->len; pos += zone_size)
+    {
+        if (idle && gen_random(gen) % 2 == 0)
+        {
+            gen_frame(&frames[len], vc_count++, CCSDS_FRAME_FHP_IDLE, NULL, 0);
+            len += frame_size;
+        }
+        // First Header Pointer: offset of the first packet starting in the zone
+        while (next_packet < pos)
+        {
+            const uint8_t* p = &gen->stream[next_packet];
+            next_packet += CCSDS_PRIMARY_HEADER_SIZE + (p[4] << 8 | p[5]) + 1;
+        }
+        uint16_t fhp = (next_packet < pos + zone_size) ? next_packet - pos : CCSDS_FRAME_FHP_NONE;
+        uint32_t n = (gen->len - pos < zone_size) ? gen->len - pos : zone_size;
+        gen_frame(&frames[len], vc_count++, fhp, &gen->stream[pos], n);
+        len += frame_size;
+    }
+    free(gen->stream);
+    gen->stream = frames;
+    gen->len = len;
+    gen->size = capacity;
+    return 0;
+}
+
+static int generate(struct capture* capture, const char* workload, uint32_t count, uint64_t seed)
+{
+    static const char* const names[] = { "random-split", "mixed-apid", "max-length", "bit-errors", "idle-fill" };
+    int kind = -1;
+    for (unsigned int i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        if (strcmp(workload, names[i]) == 0)
+        {
+            kind = i;
+        }
+    }
+    if (kind < 0)
+    {
+        fprintf(stderr, "unknown workload %s\n", workload);
+        return -1;
+    }
+    struct generator gen;
+    memset(&gen, 0, sizeof(gen));
+    gen.rng = seed ? seed : 1;
+    uint32_t corrupted = 0;
+    for (uint32_t n = 0; n < count; n++)
+    {
+        const struct ccsds_apid_config* config = gen_apid(&gen, kind == 1);
+        uint32_t max_size = gen_max_size(config);
+        uint32_t size = (kind == 2) ? max_size : 8 + gen_random(&gen) % ((max_size < 1024 ? max_size : 1024) - 7);
+        size_t start = gen.len;
+        if (gen_packet(&gen, config, size) != 0)
+        {
+            return -1;
+        }
+        // bit-errors: flip one bit in the data field of every 64th packet on average
+        if (kind == 3 && gen_random(&gen) % 64 == 0)
+        {
+            size_t offset = start + CCSDS_PRIMARY_HEADER_SIZE + gen_random(&gen) % (gen.len - start - CCSDS_PRIMARY_HEADER_SIZE);
+            gen.stream[offset] ^= 1 << (gen_random(&gen) % 8);
+            corrupted += config->crc ? 1 : 0;
+        }
+        // idle-fill: runs of zero bytes between the packets, as sent by an idle link (idle frames with frame input)
+        if (kind == 4 && !frame_input)
+        {
+            uint32_t fill = gen_random(&gen) % 512;
+            if (gen_reserve(&gen, fill) != 0)
+            {
+                return -1;
+            }
+            memset(&gen.stream[gen.len], 0, fill);
+            gen.len += fill;
+        }
+    }
+    if (frame_input && gen_frames(&gen, kind == 4) != 0)
+    {
+        return -1;
+    }
+    // cut the stream at random points into datagrams, max-length packets into full Ethernet frames,
+    // frames without ASM into datagrams of whole frames
+    uint32_t frame_size = gen_frame_size();
+    size_t pos = 0;
+    uint64_t time_us = 0;
+    while (pos < gen.len)
+    {
+        uint32_t len = (kind == 2) ? GEN_DATAGRAM_SIZE : 1 + gen_random(&gen) % GEN_DATAGRAM_SIZE;
+        if (frame_input && !FRAME_CONFIG.asm_sync)
+        {
+            len = frame_size * (1 + len / frame_size);
+        }
+        if (len > gen.len - pos)
+        {
+            len = gen.len - pos;
+        }
+        // offsets first, the stream may still move, data pointers are fixed up below
+        if (capture_add(capture, (const uint8_t*)(uintptr_t)pos, len, time_us) != 0)
+        {
+            return -1;
+        }
+        pos += len;
+        time_us += 10;
+    }
+    for (size_t i = 0; i < capture->count; i++)
+    {
+        capture->datagrams[i].data = gen.stream + (uintptr_t)capture->datagrams[i].data;
+    }
+    capture->generated = gen.stream;
+    capture->generated_len = gen.len;
+    capture->expected = gen.packets - corrupted;
+    return 0;
+}
+
+static int write_log(const struct capture* capture, const char* name)
+{
+    FILE* f = fopen(name, "wb");
+    if (f == NULL)
+    {
+        perror(name);
+        return -1;
+    }
+    fwrite(LOG_MAGIC, 1, LOG_MAGIC_SIZE, f);
+    for (size_t i = 0; i < capture->count; i++)
+    {
+        const struct datagram* d = &capture->datagrams[i];
+        uint8_t record[LOG_RECORD_SIZE];
+        for (int b = 0; b < 8; b++)
+        {
+            record[b] = (uint8_t)(d->time_us >> (8 * b));
+        }
+        for (int b = 0; b < 4; b++)
+        {
+            record[8 + b] = (uint8_t)(d->len >> (8 * b));
+        }
+        fwrite(record, 1, sizeof(record), f);
+        fwrite(d->data, 1, d->len, f);
+    }
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr,
+            "usage: %s [-p] [-n loops] [-F] [-l port] capture_file\n"
+            "       %s [-p] [-n loops] [-F] -g workload [-c packets] [-s seed] [-w log_file]\n"
+            "  -p          replay at the recorded pace instead of as fast as possible\n"
+            "  -n loops    replay the capture several times\n"
+            "  -F          TM Transfer Frame input as configured in ccsds_config.h\n"
+            "  -l port     UDP destination port of the pcap datagrams (default %d, 0: any)\n"
+            "  -g workload random-split, mixed-apid, max-length, bit-errors or idle-fill\n"
+            "  -c packets  packets of the generated workload (default 100000)\n"
+            "  -s seed     seed of the generated workload\n"
+            "  -w log_file store the generated workload as datagram log\n",
+            name, name, SERVER_UDP_PORT);
+}
+
+int main(int argc, char** argv)
+{
+    int paced = 0;
+    unsigned int loops = 1;
+    uint16_t port = SERVER_UDP_PORT;
+    const char* workload = NULL;
+    const char* log_name = NULL;
+    uint32_t count = 100000;
+    uint64_t seed = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "pn:Fl:g:c:s:w:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p':
+            paced = 1;
+            break;
+        case 'n':
+            loops = (unsigned int)atoi(optarg);
+            break;
+        case 'F':
+            frame_input = 1;
+            break;
+        case 'l':
+            port = (uint16_t)atoi(optarg);
+            break;
+        case 'g':
+            workload = optarg;
+            break;
+        case 'c':
+            count = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 0);
+            break;
+        case 'w':
+            log_name = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return (opt == 'h') ? 0 : 1;
+        }
+    }
+    if ((workload == NULL) == (optind >= argc) || loops == 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (ccsds_pool_init(&pool, POOL_CONFIG, POOL_CONFIG_COUNT) != 0)
+    {
+        fprintf(stderr, "Failed to allocate packet buffer pool\n");
+        return 1;
+    }
+    if (ccsds_apid_table_init(&apid_table, PACKET_VERSION_NUMBER, PACKET_TYPE, APID_CONFIG, APID_CONFIG_COUNT) != 0)
+    {
+        fprintf(stderr, "Invalid APID configuration\n");
+        return 1;
+    }
+    if (ccsds_metrics_init(&metrics, "replay", APID_CONFIG_COUNT) != 0 ||
+        ccsds_seq_init(&seq, &apid_table, &pool, &metrics, JOIN_SEGMENTS, replay_packet, NULL) != 0 ||
+        ccsds_fsm_init(&fsm, &apid_table, &pool, &metrics, ccsds_seq_packet, &seq) != 0)
+    {
+        fprintf(stderr, "Failed to allocate state machine buffers\n");
+        return 1;
+    }
+    if (frame_input)
+    {
+        if (ccsds_frame_init(&frame, &FRAME_CONFIG, &metrics) != 0)
+        {
+            fprintf(stderr, "Invalid frame configuration\n");
+            return 1;
+        }
+        for (unsigned int i = 0; i < CCSDS_FRAME_VCS; i++)
+        {
+            if ((FRAME_VCIDS & (1 << i)) == 0)
+            {
+                continue;
+            }
+            if (ccsds_fsm_init(&vc_fsm[i], &apid_table, &pool, &metrics, ccsds_seq_packet, &seq) != 0)
+            {
+                fprintf(stderr, "Failed to allocate state machine buffers\n");
+                return 1;
+            }
+            ccsds_frame_attach(&frame, i, &vc_fsm[i]);
+        }
+    }
+
+    struct capture capture;
+    memset(&capture, 0, sizeof(capture));
+    if ((workload != NULL) ? generate(&capture, workload, count, seed) : load_file(&capture, argv[optind], port))
+    {
+        return 1;
+    }
+    if (log_name != NULL && write_log(&capture, log_name) != 0)
+    {
+        return 1;
+    }
+    if (capture.count == 0)
+    {
+        fprintf(stderr, "no datagrams to replay\n");
+        return 1;
+    }
+    printf("CRC16 implementation: %s\n", ccsds_crc16_name());
+    printf("replaying %zu datagrams, %llu bytes, %u time(s)%s\n", capture.count,
+           (unsigned long long)capture.bytes, loops, paced ? " at recorded pace" : "");
+
+    uint64_t start = now_ns();
+    for (unsigned int loop = 0; loop < loops; loop++)
+    {
+        uint64_t loop_start = now_ns();
+        for (size_t i = 0; i < capture.count; i++)
+        {
+            const struct datagram* d = &capture.datagrams[i];
+            if (paced)
+            {
+                uint64_t due = loop_start + (d->time_us - capture.datagrams[0].time_us) * 1000;
+                while (now_ns() < due)
+                {
+                }
+            }
+            feed_start_ns = now_ns();
+            if (frame_input)
+            {
+                frame.rx_time_us = feed_start_ns / 1000;
+                ccsds_frame_feed(&frame, d->data, d->len);
+                ccsds_frame_end(&frame);
+            }
+            else
+            {
+                fsm.rx_time_us = feed_start_ns / 1000;
+                ccsds_fsm_feed(&fsm, d->data, d->len);
+            }
+        }
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    double seconds = elapsed / 1e9;
+    double total_bytes = (double)capture.bytes * loops;
+    printf("packets:   %llu (%llu bytes)", (unsigned long long)packets, (unsigned long long)packet_bytes);
+    if (capture.expected != 0)
+    {
+        printf(", expected %llu", (unsigned long long)capture.expected * loops);
+    }
+    printf("\n");
+    printf("elapsed:   %.3f s\n", seconds);
+    printf("rate:      %.0f packets/s, %.1f MB/s\n", packets / seconds, total_bytes / seconds / 1e6);
+    printf("cost:      %.1f ns/packet, %.2f ns/byte\n", packets ? elapsed / (double)packets : 0.0, elapsed / total_bytes);
+    printf("latency:   p50 %llu ns, p99 %llu ns, p99.9 %llu ns (feed of the completing datagram until delivery)\n",
+           (unsigned long long)latency_percentile(0.5), (unsigned long long)latency_percentile(0.99),
+           (unsigned long long)latency_percentile(0.999));
+    printf("hunting:   %llu bytes, %lu false locks, %llu bytes rescanned\n", (unsigned long long)metrics.hunt_bytes,
+           (unsigned long)metrics.false_locks, (unsigned long long)metrics.rescanned_bytes);
+    if (frame_input)
+    {
+        printf("frames:    %lu accepted, %lu errors, %lu filtered, %lu lost, %lu ASM losses, %lu realigned, %lu packets skipped\n",
+               (unsigned long)metrics.frames, (unsigned long)metrics.frame_errors, (unsigned long)metrics.frames_filtered,
+               (unsigned long)metrics.frames_lost, (unsigned long)metrics.frame_sync_losses, (unsigned long)metrics.realigned,
+               (unsigned long)metrics.skipped_packets);
+    }
+    for (unsigned int i = 0; i < APID_CONFIG_COUNT; i++)
+    {
+        const struct ccsds_apid_metrics* apid = &metrics.apids[i];
+        printf("apid %4u: %lu packets, %lu crc errors, %lu length errors, %lu without buffer, %lu gaps, %lu lost, %lu duplicates, %lu segment errors\n",
+               APID_CONFIG[i].apid, (unsigned long)apid->packets, (unsigned long)apid->crc_errors, (unsigned long)apid->length_errors,
+               (unsigned long)apid->pool_exhausted, (unsigned long)apid->gaps, (unsigned long)apid->lost,
+               (unsigned long)apid->duplicates, (unsigned long)apid->segment_errors);
+    }
+    // a generated workload without bit errors has to come out complete
+    if (capture.expected != 0 && strcmp(workload, "bit-errors") != 0 && packets != (uint64_t)capture.expected * loops)
+    {
+        fprintf(stderr, "packets missing\n");
+        return 2;
+    }
+    return 0;
+}
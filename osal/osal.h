@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ */
+
+#ifndef OSAL_H
+#define OSAL_H
+
+// Thin operating system abstraction used by the CCSDS core library
+// osal_rtthread.c implements it for RT-Thread/lwIP, osal_posix.c for Linux and other POSIX hosts
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define OSAL_WAIT_FOREVER   (-1)
+
+// logging
+void osal_printf(const char* fmt, ...);
+
+// memory, only used at startup and for configuration, never on the reassembly path
+void* osal_malloc(size_t size);
+void osal_free(void* ptr);
+
+// files, only used for configuration
+// whole text file in a NUL-terminated buffer from osal_malloc, NULL if it cannot be read or is larger than max_size
+char* osal_file_read(const char* path, size_t max_size);
+
+// time
+uint64_t osal_time_us(void);    // monotonic time in microseconds
+void osal_sleep_ms(uint32_t ms);
+
+// counting semaphore
+typedef struct osal_sem* osal_sem_t;
+osal_sem_t osal_sem_create(const char* name, uint32_t value);
+void osal_sem_delete(osal_sem_t sem);
+int osal_sem_take(osal_sem_t sem, int32_t timeout_ms);   // 0 if taken, -1 on timeout or error
+void osal_sem_give(osal_sem_t sem);
+
+// mutex
+typedef struct osal_mutex* osal_mutex_t;
+osal_mutex_t osal_mutex_create(const char* name);
+void osal_mutex_delete(osal_mutex_t mutex);
+void osal_mutex_lock(osal_mutex_t mutex);
+void osal_mutex_unlock(osal_mutex_t mutex);
+
+// threads
+int osal_thread_create(const char* name, void (*entry)(void* parameter), void* parameter, uint32_t stack_size, uint8_t priority);
+
+// UDP sockets
+typedef struct osal_udp* osal_udp_t;
+
+// IPv4 destination, resolved once
+struct osal_addr
+{
+    uint32_t ip;        // network byte order
+    uint16_t port;      // host byte order
+};
+
+// one datagram of a batch
+struct osal_datagram
+{
+    const void* data;
+    size_t len;
+};
+
+osal_udp_t osal_udp_open(uint16_t local_port);  // local_port 0 picks any free port
+void osal_udp_close(osal_udp_t sock);
+int osal_udp_resolve(const char* ip, uint16_t port, struct osal_addr* addr);    // 0 on success
+// send data without copying it, it can be reused as soon as the call returns, 0 on success
+int osal_udp_send(osal_udp_t sock, const struct osal_addr* dest, const void* data, size_t len);
+// send several datagrams with as few system calls as possible, returns the number of datagrams sent
+int osal_udp_send_batch(osal_udp_t sock, const struct osal_addr* dest, const struct osal_datagram* datagrams, unsigned int count);
+
+#endif
@@ -0,0 +1,419 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     timed semaphore waits on CLOCK_MONOTONIC
+ */
+
+// POSIX backend of the OSAL (Linux gateway, benchmarks)
+
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "osal.h"
+
+// a timed wait must not move with the wall clock (NTP steps, date): sem_clockwait (glibc 2.30) waits against
+// CLOCK_MONOTONIC, without it the semaphore is a counter under a condition variable on that clock
+#ifndef OSAL_SEM_CLOCKWAIT
+#if defined(__GLIBC__) && defined(__GLIBC_PREREQ)
+#if __GLIBC_PREREQ(2, 30)
+#define OSAL_SEM_CLOCKWAIT  1
+#endif
+#endif
+#endif
+#ifndef OSAL_SEM_CLOCKWAIT
+#define OSAL_SEM_CLOCKWAIT  0
+#endif
+
+struct osal_sem
+{
+#if OSAL_SEM_CLOCKWAIT
+    sem_t sem;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t value;
+#endif
+};
+
+struct osal_mutex
+{
+    pthread_mutex_t mutex;
+};
+
+struct osal_udp
+{
+    int fd;
+};
+
+struct osal_thread_start
+{
+    void (*entry)(void* parameter);
+    void* parameter;
+};
+
+void osal_printf(const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+}
+
+void* osal_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void osal_free(void* ptr)
+{
+    free(ptr);
+}
+
+char* osal_file_read(const char* path, size_t max_size)
+{
+    FILE* file = fopen(path, "r");
+    if (file == NULL)
+    {
+        return NULL;
+    }
+    char* text = malloc(max_size + 1);
+    // one byte more than allowed tells a file which is too large
+    size_t len = (text != NULL) ? fread(text, 1, max_size + 1, file) : 0;
+    int error = ferror(file);
+    fclose(file);
+    if (text == NULL || error || len > max_size)
+    {
+        free(text);
+        return NULL;
+    }
+    text[len] = '\0';
+    return text;
+}
+
+uint64_t osal_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void osal_sleep_ms(uint32_t ms)
+{
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000 };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+    {
+    }
+}
+
+// CLOCK_MONOTONIC time timeout_ms from now
+static void osal_deadline(struct timespec* ts, int32_t timeout_ms)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += timeout_ms / 1000;
+    ts->tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000)
+    {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+#if OSAL_SEM_CLOCKWAIT
+
+osal_sem_t osal_sem_create(const char* name, uint32_t value)
+{
+    (void)name;
+    struct osal_sem* sem = malloc(sizeof(*sem));
+    if (sem != NULL && sem_init(&sem->sem, 0, value) != 0)
+    {
+        free(sem);
+        sem = NULL;
+    }
+    return sem;
+}
+
+void osal_sem_delete(osal_sem_t sem)
+{
+    sem_destroy(&sem->sem);
+    free(sem);
+}
+
+int osal_sem_take(osal_sem_t sem, int32_t timeout_ms)
+{
+    int ret;
+    if (timeout_ms == OSAL_WAIT_FOREVER)
+    {
+        while ((ret = sem_wait(&sem->sem)) != 0 && errno == EINTR)
+        {
+        }
+    }
+    else
+    {
+        struct timespec ts;
+        osal_deadline(&ts, timeout_ms);
+        while ((ret = sem_clockwait(&sem->sem, CLOCK_MONOTONIC, &ts)) != 0 && errno == EINTR)
+        {
+        }
+    }
+    return (ret == 0) ? 0 : -1;
+}
+
+void osal_sem_give(osal_sem_t sem)
+{
+    sem_post(&sem->sem);
+}
+
+#else
+
+osal_sem_t osal_sem_create(const char* name, uint32_t value)
+{
+    (void)name;
+    struct osal_sem* sem = malloc(sizeof(*sem));
+    if (sem == NULL)
+    {
+        return NULL;
+    }
+    pthread_condattr_t attr;
+    int ok = pthread_condattr_init(&attr) == 0;
+    ok = ok && pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) == 0 && pthread_cond_init(&sem->cond, &attr) == 0;
+    pthread_condattr_destroy(&attr);
+    if (ok && pthread_mutex_init(&sem->lock, NULL) != 0)
+    {
+        pthread_cond_destroy(&sem->cond);
+        ok = 0;
+    }
+    if (!ok)
+    {
+        free(sem);
+        return NULL;
+    }
+    sem->value = value;
+    return sem;
+}
+
+void osal_sem_delete(osal_sem_t sem)
+{
+    pthread_cond_destroy(&sem->cond);
+    pthread_mutex_destroy(&sem->lock);
+    free(sem);
+}
+
+int osal_sem_take(osal_sem_t sem, int32_t timeout_ms)
+{
+    struct timespec ts;
+    if (timeout_ms != OSAL_WAIT_FOREVER)
+    {
+        osal_deadline(&ts, timeout_ms);
+    }
+    int ret = 0;
+    pthread_mutex_lock(&sem->lock);
+    while (sem->value == 0 && ret == 0)
+    {
+        ret = (timeout_ms == OSAL_WAIT_FOREVER) ? pthread_cond_wait(&sem->cond, &sem->lock)
+                                                : pthread_cond_timedwait(&sem->cond, &sem->lock, &ts);
+    }
+    if (sem->value != 0)
+    {
+        sem->value--;
+        ret = 0;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return (ret == 0) ? 0 : -1;
+}
+
+void osal_sem_give(osal_sem_t sem)
+{
+    pthread_mutex_lock(&sem->lock);
+    sem->value++;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->lock);
+}
+
+#endif
+
+osal_mutex_t osal_mutex_create(const char* name)
+{
+    (void)name;
+    struct osal_mutex* mutex = malloc(sizeof(*mutex));
+    if (mutex != NULL && pthread_mutex_init(&mutex->mutex, NULL) != 0)
+    {
+        free(mutex);
+        mutex = NULL;
+    }
+    return mutex;
+}
+
+void osal_mutex_delete(osal_mutex_t mutex)
+{
+    pthread_mutex_destroy(&mutex->mutex);
+    free(mutex);
+}
+
+void osal_mutex_lock(osal_mutex_t mutex)
+{
+    pthread_mutex_lock(&mutex->mutex);
+}
+
+void osal_mutex_unlock(osal_mutex_t mutex)
+{
+    pthread_mutex_unlock(&mutex->mutex);
+}
+
+static void* osal_thread_entry(void* arg)
+{
+    struct osal_thread_start start = *(struct osal_thread_start*)arg;
+    free(arg);
+    start.entry(start.parameter);
+    return NULL;
+}
+
+int osal_thread_create(const char* name, void (*entry)(void* parameter), void* parameter, uint32_t stack_size, uint8_t priority)
+{
+    // stack size and priority are tuned for the MCU, the host defaults are used instead
+    (void)stack_size;
+    (void)priority;
+    struct osal_thread_start* start = malloc(sizeof(*start));
+    if (start == NULL)
+    {
+        return -1;
+    }
+    start->entry = entry;
+    start->parameter = parameter;
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, osal_thread_entry, start) != 0)
+    {
+        free(start);
+        return -1;
+    }
+#ifdef __linux__
+    pthread_setname_np(tid, name);
+#endif
+    pthread_detach(tid);
+    return 0;
+}
+
+osal_udp_t osal_udp_open(uint16_t local_port)
+{
+    struct osal_udp* sock = malloc(sizeof(*sock));
+    if (sock == NULL)
+    {
+        return NULL;
+    }
+    sock->fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock->fd < 0)
+    {
+        free(sock);
+        return NULL;
+    }
+    if (local_port != 0)
+    {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(local_port);
+        if (bind(sock->fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+        {
+            close(sock->fd);
+            free(sock);
+            return NULL;
+        }
+    }
+    return sock;
+}
+
+void osal_udp_close(osal_udp_t sock)
+{
+    close(sock->fd);
+    free(sock);
+}
+
+int osal_udp_resolve(const char* ip, uint16_t port, struct osal_addr* addr)
+{
+    struct in_addr in;
+    if (inet_pton(AF_INET, ip, &in) != 1)
+    {
+        return -1;
+    }
+    addr->ip = in.s_addr;
+    addr->port = port;
+    return 0;
+}
+
+static void osal_sockaddr(const struct osal_addr* dest, struct sockaddr_in* addr)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = dest->ip;
+    addr->sin_port = htons(dest->port);
+}
+
+int osal_udp_send(osal_udp_t sock, const struct osal_addr* dest, const void* data, size_t len)
+{
+    struct sockaddr_in addr;
+    osal_sockaddr(dest, &addr);
+    return (sendto(sock->fd, data, len, 0, (struct sockaddr*)&addr, sizeof(addr)) == (ssize_t)len) ? 0 : -1;
+}
+
+// datagrams handed to one sendmmsg call
+#define OSAL_SEND_BATCH     32
+
+int osal_udp_send_batch(osal_udp_t sock, const struct osal_addr* dest, const struct osal_datagram* datagrams, unsigned int count)
+{
+    struct sockaddr_in addr;
+    osal_sockaddr(dest, &addr);
+    int sent = 0;
+    unsigned int pos = 0;
+#ifdef __linux__
+    struct mmsghdr msgs[OSAL_SEND_BATCH];
+    struct iovec iov[OSAL_SEND_BATCH];
+    while (pos < count)
+    {
+        unsigned int n = (count - pos < OSAL_SEND_BATCH) ? count - pos : OSAL_SEND_BATCH;
+        memset(msgs, 0, n * sizeof(msgs[0]));
+        for (unsigned int i = 0; i < n; i++)
+        {
+            iov[i].iov_base = (void*)datagrams[pos + i].data;
+            iov[i].iov_len = datagrams[pos + i].len;
+            msgs[i].msg_hdr.msg_name = &addr;
+            msgs[i].msg_hdr.msg_namelen = sizeof(addr);
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int ret = sendmmsg(sock->fd, msgs, n, 0);
+        if (ret > 0)
+        {
+            sent += ret;
+            pos += ret;
+        }
+        else if (ret == 0 || errno != EINTR)
+        {
+            // sendmmsg stops at the first datagram which fails, drop it and go on with the rest
+            pos++;
+        }
+    }
+#else
+    for (; pos < count; pos++)
+    {
+        if (sendto(sock->fd, datagrams[pos].data, datagrams[pos].len, 0, (struct sockaddr*)&addr, sizeof(addr)) == (ssize_t)datagrams[pos].len)
+        {
+            sent++;
+        }
+    }
+#endif
+    return sent;
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     lwIP raw API only with the core lock
+ */
+
+// RT-Thread/lwIP backend of the OSAL
+
+#include <rtthread.h>
+#include <lwip/api.h>
+#include <lwip/tcpip.h>
+#include <stdarg.h>
+#include <stdio.h>
+#ifdef RT_USING_DFS
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "osal.h"
+
+// the sockets are lwIP raw API pcbs used from application threads, which is only safe while holding the core lock
+#if !LWIP_TCPIP_CORE_LOCKING
+#error "osal_rtthread.c needs LWIP_TCPIP_CORE_LOCKING 1 in lwipopts.h"
+#endif
+
+void osal_printf(const char* fmt, ...)
+{
+    char line[RT_CONSOLEBUF_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    rt_vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    rt_kputs(line);
+}
+
+void* osal_malloc(size_t size)
+{
+    return rt_malloc(size);
+}
+
+void osal_free(void* ptr)
+{
+    rt_free(ptr);
+}
+
+char* osal_file_read(const char* path, size_t max_size)
+{
+#ifdef RT_USING_DFS
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    char* text = rt_malloc(max_size + 1);
+    size_t len = 0;
+    int n = 1;
+    // one byte more than allowed tells a file which is too large
+    while (text != NULL && len <= max_size && (n = read(fd, &text[len], max_size + 1 - len)) > 0)
+    {
+        len += n;
+    }
+    close(fd);
+    if (text == NULL || n < 0 || len > max_size)
+    {
+        rt_free(text);
+        return NULL;
+    }
+    text[len] = '\0';
+    return text;
+#else
+    // no file system on the board
+    (void)path;
+    (void)max_size;
+    return NULL;
+#endif
+}
+
+uint64_t osal_time_us(void)
+{
+    return (uint64_t)rt_tick_get() * 1000000 / RT_TICK_PER_SECOND;
+}
+
+void osal_sleep_ms(uint32_t ms)
+{
+    rt_thread_mdelay(ms);
+}
+
+osal_sem_t osal_sem_create(const char* name, uint32_t value)
+{
+    return (osal_sem_t)rt_sem_create(name, value, RT_IPC_FLAG_FIFO);
+}
+
+void osal_sem_delete(osal_sem_t sem)
+{
+    rt_sem_delete((rt_sem_t)sem);
+}
+
+int osal_sem_take(osal_sem_t sem, int32_t timeout_ms)
+{
+    rt_int32_t ticks = (timeout_ms == OSAL_WAIT_FOREVER) ? RT_WAITING_FOREVER : rt_tick_from_millisecond(timeout_ms);
+    return (rt_sem_take((rt_sem_t)sem, ticks) == RT_EOK) ? 0 : -1;
+}
+
+void osal_sem_give(osal_sem_t sem)
+{
+    rt_sem_release((rt_sem_t)sem);
+}
+
+osal_mutex_t osal_mutex_create(const char* name)
+{
+    return (osal_mutex_t)rt_mutex_create(name, RT_IPC_FLAG_PRIO);
+}
+
+void osal_mutex_delete(osal_mutex_t mutex)
+{
+    rt_mutex_delete((rt_mutex_t)mutex);
+}
+
+void osal_mutex_lock(osal_mutex_t mutex)
+{
+    rt_mutex_take((rt_mutex_t)mutex, RT_WAITING_FOREVER);
+}
+
+void osal_mutex_unlock(osal_mutex_t mutex)
+{
+    rt_mutex_release((rt_mutex_t)mutex);
+}
+
+int osal_thread_create(const char* name, void (*entry)(void* parameter), void* parameter, uint32_t stack_size, uint8_t priority)
+{
+    rt_thread_t tid = rt_thread_create(name, entry, parameter, stack_size, priority, 10);
+    if (tid == RT_NULL)
+    {
+        return -1;
+    }
+    return (rt_thread_startup(tid) == RT_EOK) ? 0 : -1;
+}
+
+osal_udp_t osal_udp_open(uint16_t local_port)
+{
+    LOCK_TCPIP_CORE();
+    struct udp_pcb* pcb = udp_new();
+    if (pcb != RT_NULL && local_port != 0)
+    {
+        udp_bind(pcb, IP_ADDR_ANY, local_port);
+    }
+    UNLOCK_TCPIP_CORE();
+    return (osal_udp_t)pcb;
+}
+
+void osal_udp_close(osal_udp_t sock)
+{
+    LOCK_TCPIP_CORE();
+    udp_remove((struct udp_pcb*)sock);
+    UNLOCK_TCPIP_CORE();
+}
+
+int osal_udp_resolve(const char* ip, uint16_t port, struct osal_addr* addr)
+{
+    ip4_addr_t ip4;
+    if (!ipaddr_aton(ip, &ip4))
+    {
+        return -1;
+    }
+    addr->ip = ip4_addr_get_u32(&ip4);
+    addr->port = port;
+    return 0;
+}
+
+// the payload is only referenced (PBUF_REF), lwIP prepends its headers in a pbuf of its own
+// and copies the data itself if it has to queue the datagram (e.g. pending ARP)
+static err_t osal_udp_send_ref(struct udp_pcb* pcb, const ip4_addr_t* dest_ip, uint16_t port, const void* data, size_t len)
+{
+    struct pbuf* p = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_REF);
+    if (p == RT_NULL)
+    {
+        return ERR_MEM;
+    }
+    p->payload = (void*)data;
+    err_t err = udp_sendto(pcb, p, dest_ip, port);
+    pbuf_free(p);
+    return err;
+}
+
+int osal_udp_send(osal_udp_t sock, const struct osal_addr* dest, const void* data, size_t len)
+{
+    return (osal_udp_send_batch(sock, dest, &(struct osal_datagram){ data, len }, 1) == 1) ? 0 : -1;
+}
+
+int osal_udp_send_batch(osal_udp_t sock, const struct osal_addr* dest, const struct osal_datagram* datagrams, unsigned int count)
+{
+    ip4_addr_t dest_ip;
+    ip4_addr_set_u32(&dest_ip, dest->ip);
+    int sent = 0;
+    LOCK_TCPIP_CORE();
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (osal_udp_send_ref((struct udp_pcb*)sock, &dest_ip, dest->port, datagrams[i].data, datagrams[i].len) == ERR_OK)
+        {
+            sent++;
+        }
+    }
+    UNLOCK_TCPIP_CORE();
+    return sent;
+}
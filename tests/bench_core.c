@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     fused copy and CRC
+ */
+
+// throughput gate of the two hot loops of the core: the CRC16 (ccsds_crc16_update, crc16sum and the fused
+// copy ccsds_crc16_copy of the reassembly) and the bulk SYNCWORD search (ccsds_apid_scan)
+// usage: bench_core crc_min_mbps scan_min_mbps
+// fails if one of them is slower than its threshold, the thresholds are CMake cache variables recorded for the
+// build machine (CCSDS_BENCH_CRC16_MIN_MBPS, CCSDS_BENCH_SCAN_MIN_MBPS)
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ccsds_apid.h"
+#include "ccsds_crc16.h"
+#include "osal.h"
+#include "test_util.h"
+
+unsigned int test_failures;
+
+#define BENCH_SIZE      (64 * 1024)
+#define BENCH_TIME_US   200000
+
+// keeps the results alive so the loops are not optimized away
+static volatile uint32_t bench_sink;
+
+// MB/s of the best of five runs, each running fn for BENCH_TIME_US
+static double bench_run(void (*fn)(const uint8_t* data, size_t len), const uint8_t* data)
+{
+    double best = 0;
+    for (int run = 0; run < 5; run++)
+    {
+        uint64_t bytes = 0;
+        uint64_t start = osal_time_us();
+        uint64_t elapsed;
+        do
+        {
+            fn(data, BENCH_SIZE);
+            bytes += BENCH_SIZE;
+            elapsed = osal_time_us() - start;
+        } while (elapsed < BENCH_TIME_US);
+        double mbps = (double)bytes / (double)elapsed;
+        best = (mbps > best) ? mbps : best;
+    }
+    return best;
+}
+
+static void bench_crc16_update(const uint8_t* data, size_t len)
+{
+    bench_sink += ccsds_crc16_update(CCSDS_CRC16_INIT, data, len);
+}
+
+static void bench_crc16sum(const uint8_t* data, size_t len)
+{
+    bench_sink += crc16sum(data, len, CCSDS_CRC16_INIT);
+}
+
+static uint8_t bench_copy[BENCH_SIZE];
+
+static void bench_crc16_copy(const uint8_t* data, size_t len)
+{
+    bench_sink += ccsds_crc16_copy(CCSDS_CRC16_INIT, bench_copy, data, len);
+}
+
+static struct ccsds_apid_table apid_table;
+
+static void bench_scan(const uint8_t* data, size_t len)
+{
+    bench_sink += ccsds_apid_scan(&apid_table, data, len);
+}
+
+static int bench_check(const char* name, double mbps, double min_mbps)
+{
+    int ok = mbps >= min_mbps;
+    printf("%-20s %8.0f MB/s (threshold %.0f MB/s) %s\n", name, mbps, min_mbps, ok ? "ok" : "TOO SLOW");
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s crc_min_mbps scan_min_mbps\n", argv[0]);
+        return 1;
+    }
+    double crc_min = strtod(argv[1], NULL);
+    double scan_min = strtod(argv[2], NULL);
+
+    uint8_t* crc_data = malloc(BENCH_SIZE);
+    uint8_t* scan_data = malloc(BENCH_SIZE);
+    if (crc_data == NULL || scan_data == NULL)
+    {
+        return 1;
+    }
+    ccsds_crc16_init();
+    if (ccsds_apid_table_init(&apid_table, 0, 0, test_apids, TEST_APID_COUNT) != 0)
+    {
+        return 1;
+    }
+    uint64_t state = 1;
+    for (size_t i = 0; i < BENCH_SIZE; i++)
+    {
+        crc_data[i] = (uint8_t)test_random(&state);
+        // line noise without a byte a configured SYNCWORD starts with, the search runs over the whole buffer
+        do
+        {
+            scan_data[i] = (uint8_t)test_random(&state);
+        } while (apid_table.first_byte[scan_data[i]]);
+    }
+
+    printf("crc16: %s\n", ccsds_crc16_name());
+    int ok = 1;
+    ok &= bench_check("ccsds_crc16_update", bench_run(bench_crc16_update, crc_data), crc_min);
+    ok &= bench_check("crc16sum", bench_run(bench_crc16sum, crc_data), crc_min);
+    ok &= bench_check("ccsds_crc16_copy", bench_run(bench_crc16_copy, crc_data), crc_min);
+    ok &= bench_check("ccsds_apid_scan", bench_run(bench_scan, scan_data), scan_min);
+    free(crc_data);
+    free(scan_data);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ */
+
+// fuzz harness of the reassembly core, for libFuzzer (CCSDS_FUZZER=ON with clang) and AFL
+// the first input byte selects the input stage (bit 0: raw stream or TM Transfer Frames) and seeds the cuts,
+// the rest is fed in chunks copied into heap buffers of their exact size (out-of-bounds reads are caught with
+// CCSDS_FUZZER or CCSDS_SANITIZE, both build the core with AddressSanitizer)
+// every packet delivered has to be a valid packet of a configured APID, anything else aborts
+//
+// without libFuzzer the program runs the inputs given as arguments (AFL: fuzz_reassembly @@),
+// or "-r count" random inputs built out of valid streams with bit errors, cuts and inserted bytes
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ccsds_apid.h"
+#include "ccsds_crc16.h"
+#include "ccsds_frame.h"
+#include "ccsds_fsm.h"
+#include "ccsds_metrics.h"
+#include "ccsds_pool.h"
+#include "osal.h"
+#include "test_util.h"
+
+unsigned int test_failures;
+
+static struct ccsds_apid_table apid_table;
+static struct ccsds_pool pool;
+static struct ccsds_metrics metrics;
+static struct ccsds_fsm fsm;
+static struct ccsds_frame frame;
+static int ready;
+
+static void fuzz_fail(const char* reason, const struct ccsds_buffer* packet)
+{
+    fprintf(stderr, "invalid packet delivered: %s (length %u, header %02x %02x %02x %02x %02x %02x)\n", reason,
+            (unsigned int)packet->length, packet->data[0], packet->data[1], packet->data[2], packet->data[3],
+            packet->data[4], packet->data[5]);
+    abort();
+}
+
+// the state machine must only deliver complete packets of configured APIDs which pass their CRC
+static void check_packet(void* arg, struct ccsds_buffer* packet)
+{
+    (void)arg;
+    if (packet->length < CCSDS_PRIMARY_HEADER_SIZE + 1)
+    {
+        fuzz_fail("too short", packet);
+    }
+    uint16_t word = packet->data[0] << 8 | packet->data[1];
+    const struct ccsds_apid_config* config = ccsds_apid_lookup(&apid_table, word);
+    if (config == NULL)
+    {
+        fuzz_fail("APID not configured", packet);
+    }
+    if (packet->length != CCSDS_PRIMARY_HEADER_SIZE + (packet->data[4] << 8 | packet->data[5]) + 1u)
+    {
+        fuzz_fail("length does not match the header", packet);
+    }
+    if (config->max_length != 0 && packet->length > config->max_length)
+    {
+        fuzz_fail("longer than max_length", packet);
+    }
+    if (config->crc)
+    {
+        uint16_t crc = ccsds_crc16_update(CCSDS_CRC16_INIT, packet->data, packet->length - 2);
+        if (crc != (packet->data[packet->length - 2] << 8 | packet->data[packet->length - 1]))
+        {
+            fuzz_fail("CRC mismatch", packet);
+        }
+    }
+    ccsds_buffer_free(packet);
+}
+
+static void fuzz_setup(void)
+{
+    if (ccsds_apid_table_init(&apid_table, 0, 0, test_apids, TEST_APID_COUNT) != 0 ||
+        ccsds_pool_init(&pool, test_pool_config, TEST_POOL_COUNT) != 0 ||
+        ccsds_metrics_init(&metrics, "fuzz", TEST_APID_COUNT) != 0 ||
+        ccsds_fsm_init(&fsm, &apid_table, &pool, &metrics, check_packet, NULL) != 0 ||
+        ccsds_frame_init(&frame, &test_frame_config, &metrics) != 0)
+    {
+        fprintf(stderr, "setup failed\n");
+        abort();
+    }
+    ready = 1;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    if (!ready)
+    {
+        fuzz_setup();
+    }
+    if (size < 1)
+    {
+        return 0;
+    }
+    uint8_t control = data[0];
+    data++;
+    size--;
+    int frames = control & 1;
+    ccsds_fsm_reset(&fsm);
+    ccsds_fsm_set_timeout(&fsm, 1000, (control >> 1) & 1);
+    if (frames)
+    {
+        ccsds_frame_init(&frame, &test_frame_config, &metrics);
+        ccsds_frame_attach(&frame, TEST_FRAME_VCID, &fsm);
+    }
+    uint64_t state = 0x9E3779B97F4A7C15ULL ^ control;
+    size_t pos = 0;
+    while (pos < size)
+    {
+        size_t n = test_range(&state, 1, (control & 0x80) ? 16 : 2048);
+        if (n > size - pos)
+        {
+            n = size - pos;
+        }
+        uint8_t* chunk = malloc(n);
+        memcpy(chunk, &data[pos], n);
+        if (frames)
+        {
+            ccsds_frame_feed(&frame, chunk, n);
+            ccsds_frame_end(&frame);
+        }
+        else
+        {
+            ccsds_fsm_feed(&fsm, chunk, n);
+        }
+        free(chunk);
+        pos += n;
+    }
+    // expire whatever is left, rescanning it delivers the packets of a false lock
+    ccsds_fsm_poll(&fsm, UINT64_MAX / 2);
+    ccsds_fsm_reset(&fsm);
+    for (unsigned int i = 0; i < pool.class_count; i++)
+    {
+        if (pool.classes[i].available != pool.classes[i].count)
+        {
+            fprintf(stderr, "buffer leak: %u of %u buffers of class %u returned\n", pool.classes[i].available,
+                    pool.classes[i].count, i);
+            abort();
+        }
+    }
+    return 0;
+}
+
+#ifndef CCSDS_FUZZER
+
+// valid stream with random damage, the same input format as the fuzzer
+static void fuzz_random(uint64_t seed)
+{
+    uint64_t state = seed;
+    struct test_bytes packets = { 0 };
+    struct test_bytes input = { 0 };
+    uint8_t control = (uint8_t)test_random(&state);
+    test_bytes_append(&input, &control, 1);
+    unsigned int count = test_range(&state, 1, 40);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        const struct ccsds_apid_config* config = &test_apids[test_range(&state, 0, TEST_APID_COUNT - 1)];
+        test_packet(&packets, &state, config, i, test_data_length(&state, config, ccsds_pool_max_size(&pool)));
+    }
+    if (control & 1)
+    {
+        test_frames(&input, &packets);
+    }
+    else
+    {
+        test_bytes_append(&input, packets.data, packets.len);
+    }
+    // bit errors, lost spans and random bytes
+    unsigned int damage = test_range(&state, 0, 8);
+    for (unsigned int i = 0; i < damage && input.len > 2; i++)
+    {
+        size_t at = test_range(&state, 1, input.len - 1);
+        switch (test_range(&state, 0, 2))
+        {
+        case 0:
+            input.data[at] ^= 1 << test_range(&state, 0, 7);
+            break;
+        case 1:
+        {
+            size_t n = test_range(&state, 1, 64);
+            n = (n > input.len - at) ? input.len - at : n;
+            memmove(&input.data[at], &input.data[at + n], input.len - at - n);
+            input.len -= n;
+            break;
+        }
+        default:
+            input.data[at] = (uint8_t)test_random(&state);
+            break;
+        }
+    }
+    LLVMFuzzerTestOneInput(input.data, input.len);
+    test_bytes_free(&packets);
+    test_bytes_free(&input);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 3 && strcmp(argv[1], "-r") == 0)
+    {
+        if (!ready)
+        {
+            fuzz_setup();
+        }
+        unsigned long count = strtoul(argv[2], NULL, 0);
+        for (unsigned long i = 1; i <= count; i++)
+        {
+            fuzz_random(i * 0x9E3779B97F4A7C15ULL);
+        }
+        printf("%lu random inputs passed\n", count);
+        return 0;
+    }
+    for (int i = 1; i < argc; i++)
+    {
+        FILE* file = fopen(argv[i], "rb");
+        if (file == NULL)
+        {
+            perror(argv[i]);
+            return 1;
+        }
+        struct test_bytes input = { 0 };
+        uint8_t buffer[4096];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            test_bytes_append(&input, buffer, n);
+        }
+        fclose(file);
+        LLVMFuzzerTestOneInput(input.data, input.len);
+        test_bytes_free(&input);
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,310 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     every APID configured
+ */
+
+// tests of the runtime configuration: routing rules and INI text, their syntax errors, the slots an APID keeps
+// across a reload and the hand-over of a published configuration to a reader
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ccsds_apid.h"
+#include "ccsds_conf.h"
+#include "ccsds_route.h"
+#include "osal.h"
+#include "test_util.h"
+
+unsigned int test_failures;
+
+// index of ip:port among the destinations of the table, -1 if it is none of them
+static int route_index(const struct ccsds_route_table* table, const char* ip, uint16_t port)
+{
+    struct osal_addr addr;
+    if (osal_udp_resolve(ip, port, &addr) != 0)
+    {
+        return -1;
+    }
+    for (unsigned int i = 0; i < table->dest_count; i++)
+    {
+        if (table->addr[i].ip == addr.ip && table->addr[i].port == addr.port)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// ranges, fan-out, the default rule and comments
+static void test_route_parse(void)
+{
+    struct ccsds_route_table* table = ccsds_route_table_parse("# ground segment\n"
+                                                              "100 10.0.0.1:5000\n"
+                                                              "200-299 10.0.0.2:5000 10.0.0.3:6000 # archive too\n"
+                                                              "250 10.0.0.1:5000; * 10.0.0.9:7000\n");
+    TEST_CHECK(table != NULL, "valid rules rejected");
+    if (table == NULL)
+    {
+        return;
+    }
+    int a = route_index(table, "10.0.0.1", 5000);
+    int b = route_index(table, "10.0.0.2", 5000);
+    int c = route_index(table, "10.0.0.3", 6000);
+    int d = route_index(table, "10.0.0.9", 7000);
+    TEST_CHECK(table->dest_count == 4 && a >= 0 && b >= 0 && c >= 0 && d >= 0, "%u destinations", table->dest_count);
+    TEST_CHECK(ccsds_route_lookup(table, 100) == 1 << a, "APID 100: %04x", ccsds_route_lookup(table, 100));
+    TEST_CHECK(ccsds_route_lookup(table, 200) == (1 << b | 1 << c), "APID 200: %04x", ccsds_route_lookup(table, 200));
+    TEST_CHECK(ccsds_route_lookup(table, 299) == (1 << b | 1 << c), "APID 299: %04x", ccsds_route_lookup(table, 299));
+    TEST_CHECK(ccsds_route_lookup(table, 250) == (1 << a | 1 << b | 1 << c), "APID 250: %04x", ccsds_route_lookup(table, 250));
+    TEST_CHECK(ccsds_route_lookup(table, 300) == 1 << d, "APID 300: %04x", ccsds_route_lookup(table, 300));
+    TEST_CHECK(ccsds_route_lookup(table, 2047) == 1 << d, "APID 2047: %04x", ccsds_route_lookup(table, 2047));
+    ccsds_route_table_free(table);
+
+    // without a default rule the other APIDs are not routed
+    table = ccsds_route_table_parse("0-2047 127.0.0.1:1;5 127.0.0.1:2");
+    TEST_CHECK(table != NULL && ccsds_route_lookup(table, 5) == 3 && ccsds_route_lookup(table, 6) == 1,
+               "whole range and fan-out rejected");
+    ccsds_route_table_free(table);
+    table = ccsds_route_table_parse("7 127.0.0.1:1");
+    TEST_CHECK(table != NULL && ccsds_route_lookup(table, 8) == 0, "APID without rule routed");
+    ccsds_route_table_free(table);
+}
+
+static void test_route_errors(void)
+{
+    static const char* const invalid[] = {
+        "100",                          // no destination
+        "100 10.0.0.1",                 // no port
+        "100 10.0.0.1:0",               // port 0
+        "100 10.0.0.1:65536",           // port too large
+        "100 10.0.0.1:50x0",            // port not a number
+        "100 10.0.0.256:5000",          // invalid address
+        "100 ground:5000",              // no address
+        "2048 10.0.0.1:5000",           // APID too large
+        "300-200 10.0.0.1:5000",        // reversed range
+        "100- 10.0.0.1:5000",           // open range
+        "-100 10.0.0.1:5000",           // no first APID
+        "1-2-3 10.0.0.1:5000",          // two ranges
+        "100 10.0.0.1:5000 bad",        // one of several destinations invalid
+        "x 10.0.0.1:5000",              // no APID
+    };
+    for (unsigned int i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+    {
+        struct ccsds_route_table* table = ccsds_route_table_parse(invalid[i]);
+        TEST_CHECK(table == NULL, "\"%s\" accepted", invalid[i]);
+        if (table != NULL)
+        {
+            ccsds_route_table_free(table);
+        }
+    }
+    // one more destination than a table can hold
+    char text[1024] = "1";
+    for (unsigned int i = 0; i <= CCSDS_ROUTE_MAX_DESTS; i++)
+    {
+        snprintf(&text[strlen(text)], sizeof(text) - strlen(text), " 10.0.0.%u:5000", i + 1);
+    }
+    struct ccsds_route_table* table = ccsds_route_table_parse(text);
+    TEST_CHECK(table == NULL, "%u destinations accepted", CCSDS_ROUTE_MAX_DESTS + 1);
+    if (table != NULL)
+    {
+        ccsds_route_table_free(table);
+    }
+}
+
+// the APID of a SYNCWORD of conf is configured with the given settings
+static int conf_has(const struct ccsds_conf* conf, uint16_t apid, uint8_t secondary_header, uint8_t crc, uint32_t max_length)
+{
+    uint16_t word = ccsds_syncword(conf->packet_version, conf->packet_type, secondary_header, apid);
+    const struct ccsds_apid_config* config = ccsds_apid_lookup(&conf->table, word);
+    return config != NULL && config->apid == apid && config->crc == crc && config->max_length == max_length;
+}
+
+// slot of the APID in conf, -1 if it is not configured
+static int conf_slot(const struct ccsds_conf* conf, uint16_t apid)
+{
+    for (unsigned int i = 0; i < conf->table.count; i++)
+    {
+        if (conf->apids[i].apid == apid)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void test_conf_parse(void)
+{
+    struct ccsds_conf* conf = ccsds_conf_parse("; ground station\n"
+                                               "[packet]\n"
+                                               "version = 0\n"
+                                               "type = 0\n"
+                                               "\n"
+                                               "[apids]\n"
+                                               "100 = 1 1 0      # housekeeping\n"
+                                               "200 = 0 0 0\r\n"
+                                               "815 = 1 1 4096\n"
+                                               "[routes]\n"
+                                               "100 10.0.0.1:5000\n"
+                                               "* 10.0.0.2:5000\n",
+                                               NULL);
+    TEST_CHECK(conf != NULL, "valid configuration rejected");
+    if (conf == NULL)
+    {
+        return;
+    }
+    TEST_CHECK(conf_has(conf, 100, 1, 1, 0) && conf_has(conf, 200, 0, 0, 0) && conf_has(conf, 815, 1, 1, 4096),
+               "APIDs not configured as given");
+    TEST_CHECK(!conf_has(conf, 100, 0, 1, 0) && !conf_has(conf, 300, 0, 0, 0), "unknown SYNCWORD configured");
+    TEST_CHECK(conf->routes != NULL && ccsds_route_lookup(conf->routes, 100) != ccsds_route_lookup(conf->routes, 815),
+               "routes not parsed");
+
+    // without an [apids] section the APIDs and settings of prev stay, a new [apids] replaces them
+    struct ccsds_conf* same = ccsds_conf_parse("[routes]\n* 10.0.0.3:5000\n", conf);
+    TEST_CHECK(same != NULL && conf_has(same, 100, 1, 1, 0) && conf_slot(same, 815) == conf_slot(conf, 815),
+               "APIDs of prev not taken over");
+    if (same != NULL)
+    {
+        ccsds_conf_release(same);
+    }
+    struct ccsds_conf* next = ccsds_conf_parse("[apids]\n"
+                                               "2047 = 0 1 0\n"
+                                               "815 = 1 0 2048\n"
+                                               "42 = 0 0 0\n",
+                                               conf);
+    TEST_CHECK(next != NULL, "reload rejected");
+    if (next != NULL)
+    {
+        // APIDs of prev keep their slot (and with it counters and sequence context), new ones take free slots
+        TEST_CHECK(conf_slot(next, 815) == conf_slot(conf, 815), "APID 815 moved from slot %d to %d",
+                   conf_slot(conf, 815), conf_slot(next, 815));
+        TEST_CHECK(conf_has(next, 815, 1, 0, 2048), "new settings of APID 815 not taken");
+        TEST_CHECK(conf_slot(next, 100) < 0 && !conf_has(next, 100, 1, 1, 0), "removed APID 100 still configured");
+        int slot2047 = conf_slot(next, 2047);
+        int slot42 = conf_slot(next, 42);
+        TEST_CHECK(slot2047 >= 0 && slot42 >= 0 && slot2047 != slot42 && slot2047 != conf_slot(next, 815) &&
+                   slot42 != conf_slot(next, 815), "new APIDs in slots %d and %d", slot2047, slot42);
+        TEST_CHECK(conf_has(next, 2047, 0, 1, 0) && conf_has(next, 42, 0, 0, 0), "new APIDs not configured");
+        TEST_CHECK(next->routes == NULL, "routes without [routes] section");
+        ccsds_conf_release(next);
+    }
+    ccsds_conf_release(conf);
+}
+
+static void test_conf_errors(void)
+{
+    static const char* const invalid[] = {
+        "[apid]\n",                         // unknown section
+        "100 = 1 1 0\n",                    // value outside a section
+        "[packet]\nversion = 8\n",          // version has 3 bits
+        "[packet]\ntype = 2\n",             // type has 1 bit
+        "[packet]\nsubtype = 0\n",          // unknown key
+        "[packet]\nversion = 0 0\n",        // trailing value
+        "[apids]\n2048 = 0 0 0\n",          // APID too large
+        "[apids]\n100 = 2 0 0\n",           // secondary header flag
+        "[apids]\n100 = 0 0\n",             // missing max_length
+        "[apids]\n100 0 0 0\n",             // missing '='
+        "[apids]\n100 = 0 0 70000\n",       // max_length beyond a Space Packet
+        "[apids]\n100 = 0 0 0\n100 = 1 1 0\n",  // APID configured twice
+        "[routes]\n100 10.0.0.1\n",         // invalid rule
+    };
+    for (unsigned int i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+    {
+        struct ccsds_conf* conf = ccsds_conf_parse(invalid[i], NULL);
+        TEST_CHECK(conf == NULL, "\"%s\" accepted", invalid[i]);
+        if (conf != NULL)
+        {
+            ccsds_conf_release(conf);
+        }
+    }
+    // as many APIDs as there are slots, and one more if the slots do not cover every APID
+    static char text[2048 * 16] = "[apids]\n";
+    unsigned int apids = (CCSDS_APID_SLOTS < 2048) ? CCSDS_APID_SLOTS + 1 : 2048;
+    for (unsigned int i = 0; i < apids; i++)
+    {
+        snprintf(&text[strlen(text)], sizeof(text) - strlen(text), "%u = 0 1 0\n", 2047 - i);
+    }
+    struct ccsds_conf* conf = ccsds_conf_parse(text, NULL);
+    TEST_CHECK((conf == NULL) == (apids > CCSDS_APID_SLOTS), "%u APIDs with %u slots: %s", apids, CCSDS_APID_SLOTS,
+               (conf == NULL) ? "rejected" : "accepted");
+    if (conf != NULL)
+    {
+        TEST_CHECK(conf_has(conf, 0, 0, 1, 0) && conf_has(conf, 2047, 0, 1, 0) && conf->table.count == apids,
+                   "%u APIDs not all configured", apids);
+        ccsds_conf_release(conf);
+    }
+    const struct ccsds_apid_config twice[] = { { 100, 0, 1, 0 }, { 100, 1, 1, 0 } };
+    conf = ccsds_conf_create(0, 0, twice, 2);
+    TEST_CHECK(conf == NULL, "compiled-in APID configured twice accepted");
+    if (conf != NULL)
+    {
+        ccsds_conf_release(conf);
+    }
+}
+
+// a reader keeps its configuration until it takes over a newly published one, the old one lives until retired
+static void test_conf_publish(void)
+{
+    struct ccsds_conf* first = ccsds_conf_create(0, 0, test_apids, TEST_APID_COUNT);
+    TEST_CHECK(first != NULL, "compiled-in configuration rejected");
+    if (first == NULL)
+    {
+        return;
+    }
+    ccsds_conf_publish(first);
+    struct ccsds_conf_reader reader;
+    ccsds_conf_reader_init(&reader);
+    TEST_CHECK(reader.conf == first && !ccsds_conf_reader_changed(&reader), "reader does not start with the current one");
+    TEST_CHECK(ccsds_conf_reader_update(&reader) == NULL, "update without a new configuration");
+
+    struct ccsds_conf* second = ccsds_conf_parse("[apids]\n815 = 1 1 4096\n", first);
+    TEST_CHECK(second != NULL, "reload rejected");
+    if (second == NULL)
+    {
+        return;
+    }
+    ccsds_conf_publish(second);
+    // the reader holds the only reference of the first configuration now
+    TEST_CHECK(first->refs == 1, "%u references of the replaced configuration", first->refs);
+    TEST_CHECK(ccsds_conf_reader_changed(&reader), "publish not seen by the reader");
+    TEST_CHECK(ccsds_conf_reader_update(&reader) == second && reader.old == first, "reader did not take over");
+    struct ccsds_conf* third = ccsds_conf_parse("[apids]\n2047 = 0 1 0\n", second);
+    TEST_CHECK(third != NULL, "reload rejected");
+    if (third != NULL)
+    {
+        ccsds_conf_publish(third);
+        // the previous switch has not been retired yet
+        TEST_CHECK(ccsds_conf_reader_update(&reader) == NULL, "update before the previous one was retired");
+        ccsds_conf_reader_retire(&reader);
+        TEST_CHECK(reader.old == NULL, "old configuration not retired");
+        TEST_CHECK(ccsds_conf_reader_update(&reader) == third, "update after retiring failed");
+    }
+    ccsds_conf_reader_retire(&reader);
+    ccsds_conf_release(reader.conf);
+}
+
+int main(void)
+{
+    struct
+    {
+        const char* name;
+        void (*run)(void);
+    } tests[] = {
+        { "route parse", test_route_parse },
+        { "route errors", test_route_errors },
+        { "conf parse", test_conf_parse },
+        { "conf errors", test_conf_errors },
+        { "conf publish", test_conf_publish },
+    };
+    for (unsigned int i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+        unsigned int failures = test_failures;
+        tests[i].run();
+        printf("%-18s %s\n", tests[i].name, (test_failures == failures) ? "ok" : "FAILED");
+    }
+    return (test_failures == 0) ? 0 : 1;
+}
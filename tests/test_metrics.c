@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ */
+
+// tests of the metrics export: the fields of the stats datagram, APIDs left out when idle or when the buffer
+// is full, and a buffer too small for the rest
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ccsds_apid.h"
+#include "ccsds_metrics.h"
+#include "test_util.h"
+
+unsigned int test_failures;
+
+static struct ccsds_apid_table apid_table;
+static struct ccsds_metrics metrics;
+static char json[CCSDS_METRICS_JSON_SIZE];
+
+// the counters of every test start from zero
+static void metrics_clear(void)
+{
+    struct ccsds_apid_metrics* apids = metrics.apids;
+    unsigned int apid_count = metrics.apid_count;
+    memset(&metrics, 0, sizeof(metrics));
+    memset(apids, 0, apid_count * sizeof(*apids));
+    metrics.apids = apids;
+    metrics.apid_count = apid_count;
+}
+
+static void test_json_fields(void)
+{
+    metrics_clear();
+    metrics.datagrams = 12;
+    metrics.rx_errors = 1;
+    metrics.forwarded_packets = 34;
+    struct ccsds_apid_metrics* apid = &metrics.apids[apid_table.slot[815]];
+    apid->packets = 5;
+    apid->bytes = 600;
+    apid->crc_errors = 2;
+    apid->gaps = 3;
+    apid->lost = 17;
+    apid->duplicates = 4;
+    apid->segment_errors = 6;
+    // only lost packets, no packet through: still reported
+    metrics.apids[apid_table.slot[2047]].gaps = 1;
+    size_t len = ccsds_metrics_json(&metrics, &apid_table, json, sizeof(json));
+    TEST_CHECK(len > 0 && len == strlen(json) && json[0] == '{' && json[len - 1] == '}', "no JSON object: %s", json);
+    TEST_CHECK(strstr(json, "\"datagrams\":12,") != NULL && strstr(json, "\"rx_errors\":1,") != NULL &&
+               strstr(json, "\"forwarded_packets\":34,") != NULL, "totals missing: %s", json);
+    TEST_CHECK(strstr(json, "{\"apid\":815,\"packets\":5,\"bytes\":600,\"crc_errors\":2,\"length_errors\":0,\"pool_exhausted\":0,"
+                            "\"gaps\":3,\"lost\":17,\"duplicates\":4,\"segment_errors\":6}") != NULL,
+               "APID 815 missing: %s", json);
+    TEST_CHECK(strstr(json, "{\"apid\":2047,\"packets\":0,") != NULL && strstr(json, "\"gaps\":1,") != NULL,
+               "APID 2047 missing: %s", json);
+    // idle APIDs are left out
+    TEST_CHECK(strstr(json, "\"apid\":100,") == NULL && strstr(json, "\"apid\":200,") == NULL, "idle APIDs listed: %s", json);
+    TEST_CHECK(strstr(json, "\"apids_omitted\":0,") != NULL && strstr(json, "\"reassembly_us\":{") != NULL &&
+               strstr(json, "\"latency_us\":{") != NULL, "tail missing: %s", json);
+}
+
+static void test_json_omitted(void)
+{
+    metrics_clear();
+    for (unsigned int i = 0; i < TEST_APID_COUNT; i++)
+    {
+        metrics.apids[apid_table.slot[test_apids[i].apid]].duplicates = 1;
+    }
+    size_t full = ccsds_metrics_json(&metrics, &apid_table, json, sizeof(json));
+    TEST_CHECK(full > 0 && strstr(json, "\"apids_omitted\":0,") != NULL, "all APIDs fit: %s", json);
+
+    // room for the header and the histograms but not for all APIDs: the APIDs which do not fit are counted
+    metrics_clear();
+    size_t empty = ccsds_metrics_json(&metrics, &apid_table, json, sizeof(json));
+    for (unsigned int i = 0; i < TEST_APID_COUNT; i++)
+    {
+        metrics.apids[apid_table.slot[test_apids[i].apid]].duplicates = 1;
+    }
+    size_t tail = 128 + 2 * (96 + CCSDS_HISTOGRAM_BUCKETS * 11);
+    size_t size = empty + tail + 150;
+    size_t len = ccsds_metrics_json(&metrics, &apid_table, json, size);
+    unsigned int omitted = 0;
+    const char* field = strstr(json, "\"apids_omitted\":");
+    TEST_CHECK(len > 0 && field != NULL && sscanf(field, "\"apids_omitted\":%u", &omitted) == 1,
+               "no JSON with %zu bytes: %s", size, json);
+    TEST_CHECK(omitted > 0 && omitted < TEST_APID_COUNT, "%u of %u APIDs omitted", omitted, (unsigned int)TEST_APID_COUNT);
+
+    // too small for even the header: nothing to send
+    TEST_CHECK(ccsds_metrics_json(&metrics, &apid_table, json, 64) == 0, "truncated JSON returned");
+}
+
+int main(void)
+{
+    if (ccsds_apid_table_init(&apid_table, 0, 0, test_apids, TEST_APID_COUNT) != 0 ||
+        ccsds_metrics_init(&metrics, "test", TEST_APID_COUNT) != 0)
+    {
+        fprintf(stderr, "setup failed\n");
+        return 1;
+    }
+    struct
+    {
+        const char* name;
+        void (*run)(void);
+    } tests[] = {
+        { "json fields", test_json_fields },
+        { "json omitted", test_json_omitted },
+    };
+    for (unsigned int i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+        unsigned int failures = test_failures;
+        tests[i].run();
+        printf("%-18s %s\n", tests[i].name, (test_failures == failures) ? "ok" : "FAILED");
+    }
+    return (test_failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,979 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ * 2026-10-17   Nico Maas     timeout, pool exhaustion and sequence tests
+ * 2026-10-17   Nico Maas     failing pool setup
+ * 2026-10-17   Nico Maas     hundreds of APIDs
+ * 2026-10-17   Nico Maas     sequence counters read from the metrics
+ * 2026-10-17   Nico Maas     reload which switches the CRC off
+ * 2026-10-17   Nico Maas     timeouts beyond 71 minutes
+ */
+
+// property tests of the reassembly core: valid streams are cut at random points and fed in chunks of every size,
+// the packets delivered have to be byte-exact the packets of the stream, whatever the cuts are
+// followed by the error paths: timeouts, pool exhaustion, sequence counts and joining of segments
+// every chunk lives in a heap buffer of its exact size, so with CCSDS_SANITIZE=ON a read beyond it is caught by
+// AddressSanitizer, and osal_malloc is wrapped (-Wl,--wrap=osal_malloc) to prove that feeding never allocates
+// and to let allocations fail
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ccsds_apid.h"
+#include "ccsds_crc16.h"
+#include "ccsds_frame.h"
+#include "ccsds_fsm.h"
+#include "ccsds_metrics.h"
+#include "ccsds_pool.h"
+#include "ccsds_seq.h"
+#include "osal.h"
+#include "test_util.h"
+
+unsigned int test_failures;
+
+// allocations through the OSAL, the core must not make any while it is fed
+static unsigned long malloc_calls;
+// allocations not freed yet, and the call which fails (0: none)
+static unsigned long malloc_live;
+static unsigned long malloc_fail_at;
+
+void* __real_osal_malloc(size_t size);
+void __real_osal_free(void* ptr);
+
+void* __wrap_osal_malloc(size_t size)
+{
+    malloc_calls++;
+    void* ptr = (malloc_calls == malloc_fail_at) ? NULL : __real_osal_malloc(size);
+    malloc_live += (ptr != NULL);
+    return ptr;
+}
+
+void __wrap_osal_free(void* ptr)
+{
+    malloc_live -= (ptr != NULL);
+    __real_osal_free(ptr);
+}
+
+static struct ccsds_apid_table apid_table;
+// only the APIDs with CRC: a false lock on an APID without CRC inside noise is a valid packet to the state machine
+static struct ccsds_apid_table crc_table;
+static struct ccsds_pool pool;
+static struct ccsds_metrics metrics;
+
+// packets delivered by the state machine, concatenated
+static struct test_bytes delivered;
+static unsigned int delivered_count;
+
+static void record_packet(void* arg, struct ccsds_buffer* packet)
+{
+    (void)arg;
+    test_bytes_append(&delivered, packet->data, packet->length);
+    delivered_count++;
+    ccsds_buffer_free(packet);
+}
+
+static void record_reset(void)
+{
+    delivered.len = 0;
+    delivered_count = 0;
+}
+
+// chunk sizes: whole stream, single bytes, small and large random cuts
+enum chunking
+{
+    CHUNK_WHOLE,
+    CHUNK_BYTES,
+    CHUNK_SMALL,
+    CHUNK_LARGE,
+    CHUNK_COUNT
+};
+
+static const char* const chunking_names[] = { "whole", "bytes", "small", "large" };
+
+// feed the stream cut into chunks, each copied into a heap buffer of its exact size
+static void feed_chunks(void (*feed)(void* arg, const uint8_t* data, size_t len), void* arg,
+                        const struct test_bytes* stream, enum chunking chunking, uint64_t seed)
+{
+    uint64_t state = seed;
+    size_t pos = 0;
+    while (pos < stream->len)
+    {
+        size_t n = stream->len - pos;
+        if (chunking == CHUNK_BYTES)
+        {
+            n = 1;
+        }
+        else if (chunking == CHUNK_SMALL)
+        {
+            n = test_range(&state, 1, 16);
+        }
+        else if (chunking == CHUNK_LARGE)
+        {
+            n = test_range(&state, 1, 3000);
+        }
+        if (n > stream->len - pos)
+        {
+            n = stream->len - pos;
+        }
+        uint8_t* chunk = malloc(n);
+        memcpy(chunk, &stream->data[pos], n);
+        unsigned long calls = malloc_calls;
+        feed(arg, chunk, n);
+        TEST_CHECK(malloc_calls == calls, "%lu allocations while feeding", malloc_calls - calls);
+        free(chunk);
+        pos += n;
+    }
+}
+
+static void feed_fsm(void* arg, const uint8_t* data, size_t len)
+{
+    struct ccsds_fsm* fsm = arg;
+    ccsds_fsm_feed(fsm, data, len);
+}
+
+static void feed_frame(void* arg, const uint8_t* data, size_t len)
+{
+    struct ccsds_frame* frame = arg;
+    ccsds_frame_feed(frame, data, len);
+    ccsds_frame_end(frame);
+}
+
+// every buffer is back in the pool
+static void check_pool(const char* test)
+{
+    for (unsigned int i = 0; i < pool.class_count; i++)
+    {
+        TEST_CHECK(pool.classes[i].available == pool.classes[i].count, "%s: %u of %u buffers of class %u returned", test,
+                   pool.classes[i].available, pool.classes[i].count, i);
+    }
+}
+
+// random valid packets of the given APIDs, optionally with noise (bytes which are no packet) between them
+static unsigned int make_stream(struct test_bytes* stream, uint64_t seed, unsigned int packets, int crc_only, int noise,
+                                struct test_bytes* expected)
+{
+    uint64_t state = seed;
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < packets; i++)
+    {
+        const struct ccsds_apid_config* config = &test_apids[test_range(&state, 0, TEST_APID_COUNT - 1)];
+        if (crc_only && !config->crc)
+        {
+            continue;
+        }
+        if (noise && test_range(&state, 0, 3) == 0)
+        {
+            uint32_t noise_len = test_range(&state, 1, 64);
+            for (uint32_t j = 0; j < noise_len; j++)
+            {
+                uint8_t byte = (noise == 1) ? 0 : (uint8_t)test_random(&state);
+                test_bytes_append(stream, &byte, 1);
+            }
+        }
+        size_t start = stream->len;
+        test_packet(stream, &state, config, i & 0x3FFF, test_data_length(&state, config, ccsds_pool_max_size(&pool)));
+        test_bytes_append(expected, &stream->data[start], stream->len - start);
+        count++;
+    }
+    return count;
+}
+
+// the CRC implementations agree with the bytewise one for every length, alignment and split
+static void test_crc16(void)
+{
+    static const int impls[] = { CCSDS_CRC16_BYTEWISE, CCSDS_CRC16_SLICE8, CCSDS_CRC16_PCLMUL };
+    const uint8_t check[] = "123456789";
+    uint64_t state = 1;
+    uint8_t data[4096 + 16];
+    for (size_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)test_random(&state);
+    }
+    for (unsigned int impl = 0; impl < sizeof(impls) / sizeof(impls[0]); impl++)
+    {
+        if (ccsds_crc16_select(impls[impl]) != 0)
+        {
+            printf("crc16: implementation %d not supported, skipped\n", impls[impl]);
+            continue;
+        }
+        TEST_CHECK(ccsds_crc16_update(CCSDS_CRC16_INIT, check, 9) == 0x29B1, "%s check value", ccsds_crc16_name());
+        for (unsigned int round = 0; round < 2000; round++)
+        {
+            size_t offset = test_range(&state, 0, 15);
+            size_t len = test_range(&state, 0, 4096);
+            size_t split = test_range(&state, 0, len);
+            ccsds_crc16_select(CCSDS_CRC16_BYTEWISE);
+            uint16_t reference = ccsds_crc16_update(CCSDS_CRC16_INIT, &data[offset], len);
+            ccsds_crc16_select(impls[impl]);
+            uint16_t crc = ccsds_crc16_update(CCSDS_CRC16_INIT, &data[offset], split);
+            crc = ccsds_crc16_update(crc, &data[offset + split], len - split);
+            TEST_CHECK(crc == reference, "%s: length %zu split at %zu: %04x, expected %04x", ccsds_crc16_name(), len, split,
+                       crc, reference);
+            TEST_CHECK(crc16sum(&data[offset], len, CCSDS_CRC16_INIT) == reference, "crc16sum, length %zu", len);
+            // the fused copy gives the same CRC and an exact copy, the destination has exactly len bytes
+            uint8_t* copy = malloc(len + (len == 0));
+            crc = ccsds_crc16_copy(CCSDS_CRC16_INIT, copy, &data[offset], split);
+            crc = ccsds_crc16_copy(crc, &copy[split], &data[offset + split], len - split);
+            TEST_CHECK(crc == reference && memcmp(copy, &data[offset], len) == 0, "%s copy: length %zu split at %zu",
+                       ccsds_crc16_name(), len, split);
+            free(copy);
+        }
+    }
+    ccsds_crc16_select(CCSDS_CRC16_AUTO);
+}
+
+// invalid APID configurations are rejected instead of silently dropping APIDs
+static void test_apid_table(void)
+{
+    static struct ccsds_apid_config many[CCSDS_APID_SLOTS + 1];
+    struct ccsds_apid_table table;
+    for (unsigned int i = 0; i < CCSDS_APID_SLOTS + 1; i++)
+    {
+        many[i].apid = i;
+    }
+    TEST_CHECK(ccsds_apid_table_init(&table, 0, 0, many, CCSDS_APID_SLOTS) == 0, "%u APIDs", CCSDS_APID_SLOTS);
+    TEST_CHECK(ccsds_apid_lookup(&table, ccsds_syncword(0, 0, 0, CCSDS_APID_SLOTS - 1)) == &many[CCSDS_APID_SLOTS - 1],
+               "lookup of the last slot");
+    TEST_CHECK(ccsds_apid_table_init(&table, 0, 0, many, CCSDS_APID_SLOTS + 1) != 0, "more APIDs than slots accepted");
+    TEST_CHECK(ccsds_apid_scan(&table, (const uint8_t*)"\0\0\0", 3) == 3, "rejected table matches");
+    // the same APID with and without secondary header
+    const struct ccsds_apid_config twice[] = { { 100, 0, 0, 0 }, { 200, 0, 1, 0 }, { 100, 1, 1, 0 } };
+    TEST_CHECK(ccsds_apid_table_init(&table, 0, 0, twice, 3) != 0, "APID configured twice accepted");
+}
+
+// hundreds of APIDs: the SYNCWORD search and the state machine find the packets of every one of them
+static void test_many_apids(void)
+{
+    enum { MANY = (CCSDS_APID_SLOTS < 512) ? CCSDS_APID_SLOTS : 512 };
+    static struct ccsds_apid_config many[MANY];
+    static struct ccsds_apid_table table;
+    static struct ccsds_metrics many_metrics;
+    uint8_t first_byte[256] = { 0 };
+    for (unsigned int i = 0; i < MANY; i++)
+    {
+        many[i].apid = i * 4 + (i & 3);
+        many[i].secondary_header = (i >> 2) & 1;
+        many[i].crc = 1;
+        first_byte[ccsds_syncword(0, 0, many[i].secondary_header, many[i].apid) >> 8] = 1;
+    }
+    TEST_CHECK(ccsds_apid_table_init(&table, 0, 0, many, MANY) == 0, "%u APIDs rejected", MANY);
+    TEST_CHECK(ccsds_metrics_init(&many_metrics, "many", MANY) == 0, "metrics init");
+    for (unsigned int i = 0; i < MANY; i++)
+    {
+        uint16_t word = ccsds_syncword(0, 0, many[i].secondary_header, many[i].apid);
+        TEST_CHECK(ccsds_apid_lookup(&table, word) == &many[i], "lookup of APID %u", many[i].apid);
+        TEST_CHECK(ccsds_apid_lookup(&table, word ^ 0x0800) == NULL, "APID %u with the other secondary header flag", many[i].apid);
+    }
+
+    // the search agrees with a bytewise one on random bytes
+    uint64_t state = 13;
+    uint8_t data[1024];
+    for (unsigned int round = 0; round < 200; round++)
+    {
+        size_t len = test_range(&state, 0, sizeof(data));
+        for (size_t i = 0; i < len; i++)
+        {
+            // mostly bytes no configured SYNCWORD starts with, so the search runs some distance
+            do
+            {
+                data[i] = (uint8_t)test_random(&state);
+            } while (first_byte[data[i]] && test_range(&state, 0, 63) != 0);
+        }
+        size_t reference = 0;
+        while (reference < len && !first_byte[data[reference]])
+        {
+            reference++;
+        }
+        size_t found = ccsds_apid_scan(&table, data, len);
+        TEST_CHECK(found == reference, "length %zu: %zu, expected %zu", len, found, reference);
+    }
+
+    // a stream of packets of all of them with random noise in between comes out byte-exact
+    struct test_bytes stream = { 0 };
+    struct test_bytes expected = { 0 };
+    unsigned int count = 2000;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        const struct ccsds_apid_config* config = &many[(i < MANY) ? i : test_range(&state, 0, MANY - 1)];
+        if (test_range(&state, 0, 3) == 0)
+        {
+            uint32_t noise_len = test_range(&state, 1, 16);
+            for (uint32_t j = 0; j < noise_len; j++)
+            {
+                uint8_t byte = (uint8_t)test_random(&state);
+                test_bytes_append(&stream, &byte, 1);
+            }
+        }
+        size_t start = stream.len;
+        test_packet(&stream, &state, config, i & 0x3FFF, test_range(&state, 3, 600));
+        test_bytes_append(&expected, &stream.data[start], stream.len - start);
+    }
+    struct ccsds_fsm fsm;
+    TEST_CHECK(ccsds_fsm_init(&fsm, &table, &pool, &many_metrics, record_packet, NULL) == 0, "fsm init");
+    ccsds_fsm_set_timeout(&fsm, 1000, 1);
+    record_reset();
+    feed_chunks(feed_fsm, &fsm, &stream, CHUNK_SMALL, 13);
+    // a false lock at the end of the stream waits for bytes which never come
+    ccsds_fsm_poll(&fsm, UINT64_MAX / 2);
+    TEST_CHECK(delivered_count == count && delivered.len == expected.len && memcmp(delivered.data, expected.data, expected.len) == 0,
+               "%u of %u packets, %zu of %zu bytes", delivered_count, count, delivered.len, expected.len);
+    unsigned int silent = 0;
+    for (unsigned int i = 0; i < MANY; i++)
+    {
+        silent += (many_metrics.apids[i].packets == 0);
+    }
+    TEST_CHECK(silent == 0, "%u APIDs without packets", silent);
+    ccsds_fsm_deinit(&fsm);
+    check_pool("many APIDs");
+    test_bytes_free(&stream);
+    test_bytes_free(&expected);
+}
+
+// the bulk SYNCWORD search stops exactly at the first byte a configured SYNCWORD can start with
+static void test_scan(void)
+{
+    uint64_t state = 2;
+    for (unsigned int round = 0; round < 5000; round++)
+    {
+        size_t len = test_range(&state, 0, 300);
+        uint8_t* data = malloc(len + 1);
+        // bytes which cannot start a SYNCWORD, with a few candidates in between, half of the rounds with bytes
+        // the bulk compare cannot reject (0x01 shares the high bits of the first bytes of the test APIDs)
+        uint8_t fill = (round & 1) ? 0x01 : 0x10;
+        for (size_t i = 0; i < len; i++)
+        {
+            data[i] = fill | (uint8_t)(test_random(&state) & 0xE0);
+            if (test_range(&state, 0, 200) == 0)
+            {
+                data[i] = (uint8_t)test_random(&state);
+            }
+        }
+        size_t reference = len;
+        for (size_t i = 0; i < len; i++)
+        {
+            if (apid_table.first_byte[data[i]])
+            {
+                reference = i;
+                break;
+            }
+        }
+        size_t found = ccsds_apid_scan(&apid_table, data, len);
+        TEST_CHECK(found == reference, "length %zu: %zu, expected %zu", len, found, reference);
+        free(data);
+    }
+}
+
+// a clean stream of all APIDs (with and without CRC) comes out byte-exact however it is cut
+static void test_split(void)
+{
+    for (uint64_t seed = 1; seed <= 8; seed++)
+    {
+        struct test_bytes stream = { 0 };
+        struct test_bytes expected = { 0 };
+        unsigned int count = make_stream(&stream, seed * 7919, 300, 0, 0, &expected);
+        for (int chunking = 0; chunking < CHUNK_COUNT; chunking++)
+        {
+            struct ccsds_fsm fsm;
+            TEST_CHECK(ccsds_fsm_init(&fsm, &apid_table, &pool, &metrics, record_packet, NULL) == 0, "fsm init");
+            record_reset();
+            feed_chunks(feed_fsm, &fsm, &stream, chunking, seed);
+            TEST_CHECK(delivered_count == count && delivered.len == expected.len &&
+                       memcmp(delivered.data, expected.data, expected.len) == 0,
+                       "seed %lu, %s chunks: %u of %u packets, %zu of %zu bytes", (unsigned long)seed,
+                       chunking_names[chunking], delivered_count, count, delivered.len, expected.len);
+            ccsds_fsm_deinit(&fsm);
+        }
+        check_pool("split");
+        test_bytes_free(&stream);
+        test_bytes_free(&expected);
+    }
+}
+
+// zero fill and random noise between packets with CRC: every packet is found, false locks are rescanned
+static void test_noise(void)
+{
+    for (uint64_t seed = 1; seed <= 8; seed++)
+    {
+        for (int noise = 1; noise <= 2; noise++)
+        {
+            struct test_bytes stream = { 0 };
+            struct test_bytes expected = { 0 };
+            unsigned int count = make_stream(&stream, seed * 104729, 300, 1, noise, &expected);
+            for (int chunking = 0; chunking < CHUNK_COUNT; chunking++)
+            {
+                struct ccsds_fsm fsm;
+                TEST_CHECK(ccsds_fsm_init(&fsm, &crc_table, &pool, &metrics, record_packet, NULL) == 0, "fsm init");
+                ccsds_fsm_set_timeout(&fsm, 1000, 1);
+                record_reset();
+                feed_chunks(feed_fsm, &fsm, &stream, chunking, seed);
+                // a false lock at the end of the stream waits for bytes which never come
+                ccsds_fsm_poll(&fsm, UINT64_MAX / 2);
+                TEST_CHECK(delivered_count == count && delivered.len == expected.len &&
+                           memcmp(delivered.data, expected.data, expected.len) == 0,
+                           "seed %lu, %s noise, %s chunks: %u of %u packets", (unsigned long)seed,
+                           (noise == 1) ? "zero" : "random", chunking_names[chunking], delivered_count, count);
+                ccsds_fsm_deinit(&fsm);
+            }
+            check_pool("noise");
+            test_bytes_free(&stream);
+            test_bytes_free(&expected);
+        }
+    }
+}
+
+// bytes lost in the middle of the stream: no corrupted packet is delivered and none after the gap is lost
+static void test_lost_bytes(void)
+{
+    for (uint64_t seed = 1; seed <= 32; seed++)
+    {
+        uint64_t state = seed;
+        struct test_bytes stream = { 0 };
+        struct test_bytes expected = { 0 };
+        make_stream(&stream, seed * 15485863, 200, 1, 0, &expected);
+        size_t gap = test_range(&state, 0, stream.len - 1);
+        size_t gap_len = test_range(&state, 1, 100);
+        if (gap_len > stream.len - gap)
+        {
+            gap_len = stream.len - gap;
+        }
+        struct test_bytes damaged = { 0 };
+        test_bytes_append(&damaged, stream.data, gap);
+        test_bytes_append(&damaged, &stream.data[gap + gap_len], stream.len - gap - gap_len);
+
+        struct ccsds_fsm fsm;
+        TEST_CHECK(ccsds_fsm_init(&fsm, &crc_table, &pool, &metrics, record_packet, NULL) == 0, "fsm init");
+        ccsds_fsm_set_timeout(&fsm, 1000, 1);
+        record_reset();
+        feed_chunks(feed_fsm, &fsm, &damaged, CHUNK_LARGE, seed);
+        ccsds_fsm_poll(&fsm, UINT64_MAX / 2);
+
+        // walk the expected packets: the ones before and after the gap have to come out in order, the one hit
+        // by the gap must not
+        size_t pos = 0;
+        size_t out = 0;
+        while (pos < stream.len)
+        {
+            size_t length = CCSDS_PRIMARY_HEADER_SIZE + (stream.data[pos + 4] << 8 | stream.data[pos + 5]) + 1;
+            int hit = pos < gap + gap_len && pos + length > gap;
+            if (!hit)
+            {
+                TEST_CHECK(out + length <= delivered.len && memcmp(&delivered.data[out], &stream.data[pos], length) == 0,
+                           "seed %lu: packet at %zu (gap %zu+%zu) not delivered", (unsigned long)seed, pos, gap, gap_len);
+                out += length;
+            }
+            pos += length;
+        }
+        TEST_CHECK(out == delivered.len, "seed %lu: %zu bytes delivered, %zu expected", (unsigned long)seed, delivered.len, out);
+        ccsds_fsm_deinit(&fsm);
+        check_pool("lost bytes");
+        test_bytes_free(&stream);
+        test_bytes_free(&expected);
+        test_bytes_free(&damaged);
+    }
+}
+
+// packets carried by TM Transfer Frames come out byte-exact however the frames are cut
+static void test_frames_split(void)
+{
+    for (uint64_t seed = 1; seed <= 4; seed++)
+    {
+        struct test_bytes packets = { 0 };
+        struct test_bytes expected = { 0 };
+        struct test_bytes frames = { 0 };
+        unsigned int count = make_stream(&packets, seed * 31337, 300, 0, 0, &expected);
+        test_frames(&frames, &packets);
+        for (int chunking = 0; chunking < CHUNK_COUNT; chunking++)
+        {
+            static struct ccsds_frame frame;
+            struct ccsds_fsm fsm;
+            TEST_CHECK(ccsds_frame_init(&frame, &test_frame_config, &metrics) == 0, "frame init");
+            TEST_CHECK(ccsds_fsm_init(&fsm, &apid_table, &pool, &metrics, record_packet, NULL) == 0, "fsm init");
+            ccsds_frame_attach(&frame, TEST_FRAME_VCID, &fsm);
+            record_reset();
+            feed_chunks(feed_frame, &frame, &frames, chunking, seed);
+            TEST_CHECK(delivered_count == count && delivered.len == expected.len &&
+                       memcmp(delivered.data, expected.data, expected.len) == 0,
+                       "seed %lu, %s chunks: %u of %u packets", (unsigned long)seed, chunking_names[chunking],
+                       delivered_count, count);
+            ccsds_fsm_deinit(&fsm);
+        }
+        check_pool("frames");
+        test_bytes_free(&packets);
+        test_bytes_free(&expected);
+        test_bytes_free(&frames);
+    }
+}
+
+// a corrupted frame only loses the packets it carries a part of, the state machine realigns at the next one
+static void test_frames_corrupted(void)
+{
+    const struct ccsds_frame_config* config = &test_frame_config;
+    uint32_t frame_size = CCSDS_FRAME_ASM_SIZE + config->length;
+    uint32_t zone_size = config->length - CCSDS_FRAME_PRIMARY_HEADER_SIZE - CCSDS_FRAME_FECF_SIZE;
+    for (uint64_t seed = 1; seed <= 16; seed++)
+    {
+        uint64_t state = seed;
+        struct test_bytes packets = { 0 };
+        struct test_bytes expected = { 0 };
+        struct test_bytes frames = { 0 };
+        make_stream(&packets, seed * 7877, 200, 0, 0, &expected);
+        test_frames(&frames, &packets);
+        size_t bad = test_range(&state, 0, frames.len / frame_size - 1);
+        frames.data[bad * frame_size + test_range(&state, CCSDS_FRAME_ASM_SIZE, frame_size - 1)] ^= 0x5A;
+
+        static struct ccsds_frame frame;
+        struct ccsds_fsm fsm;
+        TEST_CHECK(ccsds_frame_init(&frame, config, &metrics) == 0, "frame init");
+        TEST_CHECK(ccsds_fsm_init(&fsm, &apid_table, &pool, &metrics, record_packet, NULL) == 0, "fsm init");
+        ccsds_frame_attach(&frame, TEST_FRAME_VCID, &fsm);
+        record_reset();
+        feed_chunks(feed_frame, &frame, &frames, CHUNK_LARGE, seed);
+
+        // the packet zone of the corrupted frame in the packet stream
+        size_t zone_start = bad * zone_size;
+        size_t zone_end = zone_start + zone_size;
+        size_t pos = 0;
+        size_t out = 0;
+        while (pos < packets.len)
+        {
+            size_t length = CCSDS_PRIMARY_HEADER_SIZE + (packets.data[pos + 4] << 8 | packets.data[pos + 5]) + 1;
+            if (pos >= zone_end || pos + length <= zone_start)
+            {
+                TEST_CHECK(out + length <= delivered.len && memcmp(&delivered.data[out], &packets.data[pos], length) == 0,
+                           "seed %lu: packet at %zu (frame %zu corrupted) not delivered", (unsigned long)seed, pos, bad);
+                out += length;
+            }
+            pos += length;
+        }
+        TEST_CHECK(out == delivered.len, "seed %lu: %zu bytes delivered, %zu expected", (unsigned long)seed, delivered.len, out);
+        ccsds_fsm_deinit(&fsm);
+        check_pool("corrupted frames");
+        test_bytes_free(&packets);
+        test_bytes_free(&expected);
+        test_bytes_free(&frames);
+    }
+}
+
+// a partial packet expires once no byte arrived for the timeout: by ccsds_fsm_poll or by the next span fed,
+// the rest of it is not taken for a packet, and the bytes of an expired false lock are only searched with rescan
+static void test_timeout(void)
+{
+    uint64_t state = 3;
+    struct test_bytes packet = { 0 };
+    test_packet(&packet, &state, &test_apids[0], 1, 200);
+    struct ccsds_fsm fsm;
+    TEST_CHECK(ccsds_fsm_init(&fsm, &crc_table, &pool, &metrics, record_packet, NULL) == 0, "fsm init");
+    record_reset();
+
+    // without a timeout a partial packet waits forever
+    fsm.rx_time_us = 1000;
+    ccsds_fsm_feed(&fsm, packet.data, 100);
+    TEST_CHECK(ccsds_fsm_timeout(&fsm, 1000) == OSAL_WAIT_FOREVER, "timeout without deadline");
+    TEST_CHECK(ccsds_fsm_poll(&fsm, UINT64_MAX / 2) == 0, "expired without timeout");
+
+    // deadline 10 ms behind the last span
+    ccsds_fsm_set_timeout(&fsm, 10, 0);
+    uint32_t expired = metrics.expired;
+    TEST_CHECK(ccsds_fsm_timeout(&fsm, 1000) == 10, "%d ms until the deadline, 10 expected", (int)ccsds_fsm_timeout(&fsm, 1000));
+    TEST_CHECK(ccsds_fsm_timeout(&fsm, 5500) == 6, "%d ms until the deadline, 6 expected", (int)ccsds_fsm_timeout(&fsm, 5500));
+    TEST_CHECK(ccsds_fsm_poll(&fsm, 10999) == 0, "expired before the deadline");
+    TEST_CHECK(ccsds_fsm_poll(&fsm, 11000) == 1, "not expired at the deadline");
+    TEST_CHECK(metrics.expired == expired + 1, "%u expired, 1 expected", metrics.expired - expired);
+    TEST_CHECK(ccsds_fsm_timeout(&fsm, 11000) == OSAL_WAIT_FOREVER, "deadline left after expiry");
+    fsm.rx_time_us = 12000;
+    ccsds_fsm_feed(&fsm, &packet.data[100], packet.len - 100);
+    ccsds_fsm_feed(&fsm, packet.data, packet.len);
+    TEST_CHECK(delivered_count == 1 && delivered.len == packet.len && memcmp(delivered.data, packet.data, packet.len) == 0,
+               "poll: %u packets, %zu bytes delivered", delivered_count, delivered.len);
+
+    // the next span expires the partial packet before it is fed, it does not complete the old one
+    record_reset();
+    fsm.rx_time_us = 20000;
+    ccsds_fsm_feed(&fsm, packet.data, 100);
+    fsm.rx_time_us = 30000;
+    ccsds_fsm_feed(&fsm, packet.data, packet.len);
+    TEST_CHECK(metrics.expired == expired + 2, "%u expired, 2 expected", metrics.expired - expired);
+    TEST_CHECK(delivered_count == 1 && delivered.len == packet.len && memcmp(delivered.data, packet.data, packet.len) == 0,
+               "feed: %u packets, %zu bytes delivered", delivered_count, delivered.len);
+
+    // timeouts whose us do not fit into 32 bit: 2 hours, and the longest one, whose wait is clamped
+    record_reset();
+    ccsds_fsm_set_timeout(&fsm, 7200000, 0);
+    fsm.rx_time_us = 40000;
+    ccsds_fsm_feed(&fsm, packet.data, 100);
+    TEST_CHECK(ccsds_fsm_timeout(&fsm, 40000) == 7200000, "%d ms until the deadline, 7200000 expected",
+               (int)ccsds_fsm_timeout(&fsm, 40000));
+    TEST_CHECK(ccsds_fsm_poll(&fsm, 40000 + 7199999999ULL) == 0, "2 hour timeout expired early");
+    TEST_CHECK(ccsds_fsm_poll(&fsm, 40000 + 7200000000ULL) == 1, "2 hour timeout not expired");
+    ccsds_fsm_set_timeout(&fsm, UINT32_MAX, 0);
+    ccsds_fsm_feed(&fsm, packet.data, 100);
+    TEST_CHECK(ccsds_fsm_timeout(&fsm, 40000) == INT32_MAX, "%d ms until the deadline, INT32_MAX expected",
+               (int)ccsds_fsm_timeout(&fsm, 40000));
+    TEST_CHECK(ccsds_fsm_poll(&fsm, 40000 + (uint64_t)UINT32_MAX * 1000 - 1) == 0, "longest timeout expired early");
+    TEST_CHECK(ccsds_fsm_poll(&fsm, 40000 + (uint64_t)UINT32_MAX * 1000) == 1, "longest timeout not expired");
+    TEST_CHECK(delivered_count == 0, "%u packets out of expired partial packets", delivered_count);
+
+    // a false lock with a long data length swallows the packet behind it
+    uint16_t word = ccsds_syncword(0, 0, test_apids[0].secondary_header, test_apids[0].apid);
+    const uint8_t false_lock[CCSDS_PRIMARY_HEADER_SIZE] = { word >> 8, word & 0xFF, 0xC0, 0, 3999 >> 8, 3999 & 0xFF };
+    for (uint8_t rescan = 0; rescan <= 1; rescan++)
+    {
+        record_reset();
+        ccsds_fsm_set_timeout(&fsm, 10, rescan);
+        fsm.rx_time_us = 100000;
+        ccsds_fsm_feed(&fsm, false_lock, sizeof(false_lock));
+        ccsds_fsm_feed(&fsm, packet.data, packet.len);
+        TEST_CHECK(delivered_count == 0, "rescan %u: %u packets delivered before the deadline", rescan, delivered_count);
+        TEST_CHECK(ccsds_fsm_poll(&fsm, 110000) == 1, "rescan %u: false lock not expired", rescan);
+        TEST_CHECK(delivered_count == rescan, "rescan %u: %u packets delivered after expiry", rescan, delivered_count);
+    }
+    ccsds_fsm_deinit(&fsm);
+    check_pool("timeout");
+    test_bytes_free(&packet);
+}
+
+// hold every buffer of the pool which can take at least size bytes, returns how many
+static unsigned int drain_pool(struct ccsds_buffer** held, unsigned int max, uint32_t size)
+{
+    unsigned int count = 0;
+    while (count < max && (held[count] = ccsds_pool_alloc(&pool, size)) != NULL)
+    {
+        count++;
+    }
+    return count;
+}
+
+static void release_pool(struct ccsds_buffer** held, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; i++)
+    {
+        ccsds_buffer_free(held[i]);
+    }
+}
+
+// a pool which cannot be set up leaves nothing allocated, whichever class fails
+static void test_pool_init(void)
+{
+    struct ccsds_pool failing;
+    for (unsigned int fail = 1; fail <= TEST_POOL_COUNT; fail++)
+    {
+        unsigned long live = malloc_live;
+        malloc_fail_at = malloc_calls + fail;
+        int result = ccsds_pool_init(&failing, test_pool_config, TEST_POOL_COUNT);
+        malloc_fail_at = 0;
+        TEST_CHECK(result == -1 && malloc_live == live, "allocation %u failed: result %d, %lu allocations left", fail,
+                   result, malloc_live - live);
+    }
+    static const unsigned int descending[][2] = { { 512, 4 }, { 4096, 4 }, { 1024, 4 } };
+    unsigned long live = malloc_live;
+    TEST_CHECK(ccsds_pool_init(&failing, descending, 3) == -1 && malloc_live == live,
+               "classes not ascending: %lu allocations left", malloc_live - live);
+}
+
+// without a free buffer the packet is skipped and counted, the state machine stays in sync with the stream
+static void test_pool_exhausted(void)
+{
+    uint64_t state = 5;
+    struct test_bytes skipped = { 0 };
+    struct test_bytes packet = { 0 };
+    test_packet(&skipped, &state, &test_apids[0], 1, 300);
+    test_packet(&packet, &state, &test_apids[1], 2, 50);
+    struct ccsds_fsm fsm;
+    TEST_CHECK(ccsds_fsm_init(&fsm, &apid_table, &pool, &metrics, record_packet, NULL) == 0, "fsm init");
+    record_reset();
+    struct ccsds_buffer* held[128];
+    unsigned int count = drain_pool(held, 128, 1);
+    uint32_t exhausted = metrics.apids[apid_table.slot[test_apids[0].apid]].pool_exhausted;
+    uint64_t hunt_bytes = metrics.hunt_bytes;
+    uint32_t false_locks = metrics.false_locks;
+    ccsds_fsm_feed(&fsm, skipped.data, skipped.len);
+    release_pool(held, count);
+    ccsds_fsm_feed(&fsm, packet.data, packet.len);
+    TEST_CHECK(metrics.apids[apid_table.slot[test_apids[0].apid]].pool_exhausted == exhausted + 1, "pool exhaustion not counted");
+    TEST_CHECK(metrics.hunt_bytes == hunt_bytes && metrics.false_locks == false_locks,
+               "out of sync: %lu bytes hunted, %u false locks", (unsigned long)(metrics.hunt_bytes - hunt_bytes),
+               metrics.false_locks - false_locks);
+    TEST_CHECK(delivered_count == 1 && delivered.len == packet.len && memcmp(delivered.data, packet.data, packet.len) == 0,
+               "%u packets, %zu bytes delivered", delivered_count, delivered.len);
+    ccsds_fsm_deinit(&fsm);
+    check_pool("pool exhausted");
+    test_bytes_free(&skipped);
+    test_bytes_free(&packet);
+}
+
+// append a valid packet with the given sequence flags
+static void make_segment(struct test_bytes* stream, uint64_t* state, const struct ccsds_apid_config* config, uint8_t flags,
+                         uint16_t count, uint32_t data_length)
+{
+    size_t start = stream->len;
+    test_packet(stream, state, config, count, data_length);
+    uint8_t* p = &stream->data[start];
+    size_t length = stream->len - start;
+    p[2] = (p[2] & 0x3F) | flags << 6;
+    if (config->crc)
+    {
+        uint16_t crc = ccsds_crc16_update(CCSDS_CRC16_INIT, p, length - 2);
+        p[length - 2] = crc >> 8;
+        p[length - 1] = crc & 0xFF;
+    }
+}
+
+// hand the packets of a stream to the sequence tracking, each in a buffer of the pool
+static void feed_seq(struct ccsds_seq* seq, const struct test_bytes* stream)
+{
+    size_t pos = 0;
+    while (pos < stream->len)
+    {
+        uint32_t length = CCSDS_PRIMARY_HEADER_SIZE + (stream->data[pos + 4] << 8 | stream->data[pos + 5]) + 1;
+        struct ccsds_buffer* packet = ccsds_pool_alloc(&pool, length);
+        memcpy(packet->data, &stream->data[pos], length);
+        packet->length = length;
+        ccsds_seq_packet(seq, packet);
+        pos += length;
+    }
+}
+
+// the unit ccsds_seq joins out of the segments of a stream: primary header of the first segment, the data
+// fields without their CRC and a CRC over the unit
+static void make_joined(struct test_bytes* expected, const struct test_bytes* stream, uint8_t crc)
+{
+    uint32_t crc_length = crc ? 2 : 0;
+    expected->len = 0;
+    size_t pos = 0;
+    while (pos < stream->len)
+    {
+        const uint8_t* p = &stream->data[pos];
+        uint32_t length = CCSDS_PRIMARY_HEADER_SIZE + (p[4] << 8 | p[5]) + 1;
+        uint32_t skip = (pos == 0) ? 0 : CCSDS_PRIMARY_HEADER_SIZE;
+        test_bytes_append(expected, &p[skip], length - skip - crc_length);
+        pos += length;
+    }
+    uint32_t data_length = expected->len + crc_length - CCSDS_PRIMARY_HEADER_SIZE - 1;
+    expected->data[2] |= CCSDS_SEQ_UNSEGMENTED << 6;
+    expected->data[4] = data_length >> 8;
+    expected->data[5] = data_length & 0xFF;
+    if (crc)
+    {
+        uint16_t sum = ccsds_crc16_update(CCSDS_CRC16_INIT, expected->data, expected->len);
+        uint8_t sent[2] = { sum >> 8, sum & 0xFF };
+        test_bytes_append(expected, sent, 2);
+    }
+}
+
+// gaps, lost packets and duplicates of the 14 bit sequence count, which wraps around
+static void test_seq_count(void)
+{
+    static const uint16_t counts[] = { 0x3FFE, 0x3FFF, 0, 1, 4, 4, 5 };
+    const struct ccsds_apid_config* config = &test_apids[1];
+    uint64_t state = 7;
+    struct test_bytes stream = { 0 };
+    for (unsigned int i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        make_segment(&stream, &state, config, CCSDS_SEQ_UNSEGMENTED, counts[i], 20);
+    }
+    struct ccsds_apid_metrics* counters = &metrics.apids[apid_table.slot[config->apid]];
+    memset(counters, 0, sizeof(*counters));
+    struct ccsds_seq seq;
+    TEST_CHECK(ccsds_seq_init(&seq, &apid_table, &pool, &metrics, 1, record_packet, NULL) == 0, "seq init");
+    record_reset();
+    feed_seq(&seq, &stream);
+    TEST_CHECK(counters->gaps == 1 && counters->lost == 2 && counters->duplicates == 1,
+               "%u gaps, %u lost, %u duplicates", counters->gaps, counters->lost, counters->duplicates);
+    TEST_CHECK(delivered_count == 6, "%u packets delivered, 6 expected", delivered_count);
+    ccsds_seq_deinit(&seq);
+    check_pool("seq count");
+    test_bytes_free(&stream);
+}
+
+// segmented user data is joined into one packet with a new CRC, incomplete units are dropped and counted
+static void test_seq_join(void)
+{
+    const struct ccsds_apid_config* config = &test_apids[2];
+    uint64_t state = 11;
+    struct test_bytes stream = { 0 };
+    make_segment(&stream, &state, config, CCSDS_SEQ_FIRST, 10, 100);
+    make_segment(&stream, &state, config, CCSDS_SEQ_CONTINUATION, 11, 50);
+    make_segment(&stream, &state, config, CCSDS_SEQ_LAST, 12, 30);
+
+    struct test_bytes expected = { 0 };
+    make_joined(&expected, &stream, config->crc);
+
+    uint16_t slot = apid_table.slot[config->apid];
+    struct ccsds_apid_metrics* counters = &metrics.apids[slot];
+    memset(counters, 0, sizeof(*counters));
+    struct ccsds_seq seq;
+    TEST_CHECK(ccsds_seq_init(&seq, &apid_table, &pool, &metrics, 1, record_packet, NULL) == 0, "seq init");
+    record_reset();
+    feed_seq(&seq, &stream);
+    TEST_CHECK(delivered_count == 1 && delivered.len == expected.len && memcmp(delivered.data, expected.data, expected.len) == 0,
+               "%u packets, %zu of %zu bytes delivered", delivered_count, delivered.len, expected.len);
+
+    const struct ccsds_apid_context* context = &seq.contexts[slot];
+    // continuation without first segment
+    stream.len = 0;
+    make_segment(&stream, &state, config, CCSDS_SEQ_CONTINUATION, 13, 50);
+    feed_seq(&seq, &stream);
+    TEST_CHECK(counters->segment_errors == 1, "continuation without first: %u segment errors", counters->segment_errors);
+    // a gap in the sequence count loses segments of the open unit
+    stream.len = 0;
+    make_segment(&stream, &state, config, CCSDS_SEQ_FIRST, 14, 50);
+    make_segment(&stream, &state, config, CCSDS_SEQ_LAST, 16, 50);
+    feed_seq(&seq, &stream);
+    TEST_CHECK(counters->segment_errors == 3 && counters->gaps == 1,
+               "gap: %u segment errors, %u gaps", counters->segment_errors, counters->gaps);
+    // the join buffer is sized by max_length, a unit growing beyond it is dropped
+    stream.len = 0;
+    make_segment(&stream, &state, config, CCSDS_SEQ_FIRST, 17, 3000);
+    feed_seq(&seq, &stream);
+    TEST_CHECK(context->unit != NULL && context->unit->size == config->max_length,
+               "join buffer of %u bytes, max_length %u", (context->unit != NULL) ? context->unit->size : 0, config->max_length);
+    stream.len = 0;
+    make_segment(&stream, &state, config, CCSDS_SEQ_CONTINUATION, 18, 2000);
+    feed_seq(&seq, &stream);
+    TEST_CHECK(context->unit == NULL && counters->segment_errors == 4, "too long: %u segment errors", counters->segment_errors);
+    // no buffer for the unit
+    struct ccsds_buffer* held[128];
+    unsigned int count = drain_pool(held, 128, config->max_length);
+    stream.len = 0;
+    make_segment(&stream, &state, config, CCSDS_SEQ_FIRST, 19, 50);
+    feed_seq(&seq, &stream);
+    release_pool(held, count);
+    TEST_CHECK(context->unit == NULL && counters->segment_errors == 5 && counters->pool_exhausted == 1,
+               "pool exhausted: %u segment errors, %u counted", counters->segment_errors, counters->pool_exhausted);
+    TEST_CHECK(delivered_count == 1, "%u packets delivered out of incomplete units", delivered_count - 1);
+    ccsds_seq_deinit(&seq);
+
+    // without joining every segment is passed on as it is
+    stream.len = 0;
+    make_segment(&stream, &state, config, CCSDS_SEQ_FIRST, 20, 100);
+    make_segment(&stream, &state, config, CCSDS_SEQ_CONTINUATION, 21, 50);
+    make_segment(&stream, &state, config, CCSDS_SEQ_LAST, 22, 30);
+    TEST_CHECK(ccsds_seq_init(&seq, &apid_table, &pool, &metrics, 0, record_packet, NULL) == 0, "seq init");
+    record_reset();
+    feed_seq(&seq, &stream);
+    TEST_CHECK(delivered_count == 3 && delivered.len == stream.len && memcmp(delivered.data, stream.data, stream.len) == 0,
+               "no join: %u packets, %zu bytes delivered", delivered_count, delivered.len);
+    ccsds_seq_deinit(&seq);
+    check_pool("seq join");
+    test_bytes_free(&stream);
+    test_bytes_free(&expected);
+}
+
+// a reload which switches the CRC of an APID off: the state machine finishes its partial packet under the
+// previous configuration and the sequence stage has to join it with those settings, a unit opened under
+// the previous settings is not continued under the new ones
+static void test_seq_reload(void)
+{
+    const struct ccsds_apid_config* config = &test_apids[2];
+    struct ccsds_apid_config no_crc_apids[TEST_APID_COUNT];
+    memcpy(no_crc_apids, test_apids, sizeof(no_crc_apids));
+    no_crc_apids[2].crc = 0;
+    const struct ccsds_apid_config* no_crc = &no_crc_apids[2];
+    static struct ccsds_apid_table no_crc_table;
+    TEST_CHECK(ccsds_apid_table_init(&no_crc_table, 0, 0, no_crc_apids, TEST_APID_COUNT) == 0, "table init");
+    uint16_t slot = apid_table.slot[config->apid];
+    struct ccsds_apid_metrics* counters = &metrics.apids[slot];
+    memset(counters, 0, sizeof(*counters));
+    struct ccsds_seq seq;
+    struct ccsds_fsm fsm;
+    TEST_CHECK(ccsds_seq_init(&seq, &apid_table, &pool, &metrics, 1, record_packet, NULL) == 0, "seq init");
+    TEST_CHECK(ccsds_fsm_init(&fsm, &apid_table, &pool, &metrics, ccsds_seq_packet, &seq) == 0, "fsm init");
+    uint64_t state = 23;
+    struct test_bytes stream = { 0 };
+    struct test_bytes expected = { 0 };
+
+    // reload in the middle of the last segment, it still completes with a CRC
+    make_segment(&stream, &state, config, CCSDS_SEQ_FIRST, 30, 100);
+    make_segment(&stream, &state, config, CCSDS_SEQ_LAST, 31, 80);
+    make_joined(&expected, &stream, 1);
+    record_reset();
+    ccsds_fsm_feed(&fsm, stream.data, stream.len - 40);
+    ccsds_fsm_set_apids(&fsm, &no_crc_table);
+    ccsds_seq_set_apids(&seq, &no_crc_table);
+    TEST_CHECK(ccsds_fsm_switching(&fsm), "partial packet switched to the new configuration");
+    ccsds_fsm_feed(&fsm, &stream.data[stream.len - 40], 40);
+    TEST_CHECK(delivered_count == 1 && delivered.len == expected.len && memcmp(delivered.data, expected.data, expected.len) == 0,
+               "old configuration: %u packets, %zu of %zu bytes delivered", delivered_count, delivered.len, expected.len);
+
+    // the next unit is joined without CRC
+    stream.len = 0;
+    make_segment(&stream, &state, no_crc, CCSDS_SEQ_FIRST, 32, 100);
+    make_segment(&stream, &state, no_crc, CCSDS_SEQ_LAST, 33, 80);
+    make_joined(&expected, &stream, 0);
+    record_reset();
+    ccsds_fsm_feed(&fsm, stream.data, stream.len);
+    TEST_CHECK(delivered_count == 1 && delivered.len == expected.len && memcmp(delivered.data, expected.data, expected.len) == 0,
+               "new configuration: %u packets, %zu of %zu bytes delivered", delivered_count, delivered.len, expected.len);
+
+    // a unit opened without CRC is dropped when the CRC is switched on again, its last segment has no first one then
+    stream.len = 0;
+    make_segment(&stream, &state, no_crc, CCSDS_SEQ_FIRST, 34, 100);
+    ccsds_fsm_feed(&fsm, stream.data, stream.len);
+    ccsds_fsm_set_apids(&fsm, &apid_table);
+    ccsds_seq_set_apids(&seq, &apid_table);
+    stream.len = 0;
+    make_segment(&stream, &state, config, CCSDS_SEQ_LAST, 35, 80);
+    record_reset();
+    ccsds_fsm_feed(&fsm, stream.data, stream.len);
+    TEST_CHECK(delivered_count == 0 && seq.contexts[slot].unit == NULL && counters->segment_errors == 2,
+               "unit across the reload: %u packets, %u segment errors", delivered_count, counters->segment_errors);
+    TEST_CHECK(counters->gaps == 0, "%u gaps across the reload", counters->gaps);
+
+    ccsds_fsm_deinit(&fsm);
+    ccsds_seq_deinit(&seq);
+    check_pool("seq reload");
+    test_bytes_free(&stream);
+    test_bytes_free(&expected);
+}
+
+int main(void)
+{
+    struct ccsds_apid_config crc_apids[TEST_APID_COUNT];
+    for (unsigned int i = 0; i < TEST_APID_COUNT; i++)
+    {
+        crc_apids[i] = test_apids[i];
+        crc_apids[i].apid = test_apids[i].crc ? test_apids[i].apid : CCSDS_APID_UNUSED;
+    }
+    if (ccsds_apid_table_init(&apid_table, 0, 0, test_apids, TEST_APID_COUNT) != 0 ||
+        ccsds_apid_table_init(&crc_table, 0, 0, crc_apids, TEST_APID_COUNT) != 0 ||
+        ccsds_pool_init(&pool, test_pool_config, TEST_POOL_COUNT) != 0 ||
+        ccsds_metrics_init(&metrics, "test", TEST_APID_COUNT) != 0)
+    {
+        fprintf(stderr, "setup failed\n");
+        return 1;
+    }
+    struct
+    {
+        const char* name;
+        void (*run)(void);
+    } tests[] = {
+        { "crc16", test_crc16 },
+        { "apid table", test_apid_table },
+        { "scan", test_scan },
+        { "many APIDs", test_many_apids },
+        { "split", test_split },
+        { "noise", test_noise },
+        { "lost bytes", test_lost_bytes },
+        { "frames split", test_frames_split },
+        { "frames corrupted", test_frames_corrupted },
+        { "timeout", test_timeout },
+        { "pool init", test_pool_init },
+        { "pool exhausted", test_pool_exhausted },
+        { "seq count", test_seq_count },
+        { "seq join", test_seq_join },
+        { "seq reload", test_seq_reload },
+    };
+    for (unsigned int i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+        unsigned int failures = test_failures;
+        tests[i].run();
+        printf("%-18s %s\n", tests[i].name, (test_failures == failures) ? "ok" : "FAILED");
+    }
+    test_bytes_free(&delivered);
+    return (test_failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2023, Nico Maas
+ *
+ * Change Logs:
+ * Date         Author        Notes
+ * 2026-10-17   Nico Maas     first version
+ */
+
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+// helpers shared by the tests and the fuzz harness: random numbers, packet and frame streams
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ccsds_apid.h"
+#include "ccsds_crc16.h"
+#include "ccsds_frame.h"
+#include "ccsds_pool.h"
+
+// failed checks are counted, the test returns non-zero if there was any
+extern unsigned int test_failures;
+
+#define TEST_CHECK(cond, ...)                                               \
+    do                                                                      \
+    {                                                                       \
+        if (!(cond))                                                        \
+        {                                                                   \
+            test_failures++;                                                \
+            fprintf(stderr, "%s:%d: check failed: %s: ", __FILE__, __LINE__, #cond); \
+            fprintf(stderr, __VA_ARGS__);                                   \
+            fprintf(stderr, "\n");                                          \
+        }                                                                   \
+    } while (0)
+
+// APIDs of the tests: with and without secondary header, with and without CRC, a length limit
+static const struct ccsds_apid_config test_apids[] = {
+    { 100, 1, 1, 0 },
+    { 200, 0, 0, 0 },
+    { 815, 1, 1, 4096 },
+    { 2047, 0, 1, 0 },
+};
+#define TEST_APID_COUNT     (sizeof(test_apids) / sizeof(test_apids[0]))
+
+// buffers for packets up to the largest Space Packet
+static const unsigned int test_pool_config[][2] = { { 512, 64 }, { 4096, 32 }, { CCSDS_MAX_PACKET_SIZE, 4 } };
+#define TEST_POOL_COUNT     (sizeof(test_pool_config) / (2 * sizeof(unsigned int)))
+
+// xorshift64*, deterministic for a seed
+static inline uint64_t test_random(uint64_t* state)
+{
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+// random number in [low, high]
+static inline uint32_t test_range(uint64_t* state, uint32_t low, uint32_t high)
+{
+    return low + (uint32_t)(test_random(state) % ((uint64_t)high - low + 1));
+}
+
+// growing byte buffer
+struct test_bytes
+{
+    uint8_t* data;
+    size_t len;
+    size_t size;
+};
+
+static inline void test_bytes_append(struct test_bytes* bytes, const void* data, size_t len)
+{
+    if (bytes->len + len > bytes->size)
+    {
+        bytes->size = (bytes->len + len) * 2;
+        bytes->data = realloc(bytes->data, bytes->size);
+        if (bytes->data == NULL)
+        {
+            abort();
+        }
+    }
+    memcpy(&bytes->data[bytes->len], data, len);
+    bytes->len += len;
+}
+
+static inline void test_bytes_free(struct test_bytes* bytes)
+{
+    free(bytes->data);
+    memset(bytes, 0, sizeof(*bytes));
+}
+
+// append one valid packet of the configuration with a data field of data_length bytes (including the CRC)
+static inline void test_packet(struct test_bytes* stream, uint64_t* state, const struct ccsds_apid_config* config,
+                               uint16_t count, uint32_t data_length)
+{
+    uint8_t header[CCSDS_PRIMARY_HEADER_SIZE];
+    uint16_t word = ccsds_syncword(0, 0, config->secondary_header, config->apid);
+    header[0] = word >> 8;
+    header[1] = word & 0xFF;
+    header[2] = 0xC0 | ((count >> 8) & 0x3F);
+    header[3] = count & 0xFF;
+    header[4] = (data_length - 1) >> 8;
+    header[5] = (data_length - 1) & 0xFF;
+    size_t start = stream->len;
+    test_bytes_append(stream, header, sizeof(header));
+    uint32_t payload = data_length - (config->crc ? 2 : 0);
+    for (uint32_t i = 0; i < payload; i++)
+    {
+        uint8_t byte = (uint8_t)test_random(state);
+        test_bytes_append(stream, &byte, 1);
+    }
+    if (config->crc)
+    {
+        uint16_t crc = ccsds_crc16_update(CCSDS_CRC16_INIT, &stream->data[start], stream->len - start);
+        uint8_t sent[2] = { crc >> 8, crc & 0xFF };
+        test_bytes_append(stream, sent, 2);
+    }
+}
+
+// data field length of a random packet of the configuration, mostly small, sometimes up to the limit
+static inline uint32_t test_data_length(uint64_t* state, const struct ccsds_apid_config* config, uint32_t max_size)
+{
+    uint32_t limit = (config->max_length != 0 && config->max_length < max_size) ? config->max_length : max_size;
+    uint32_t max_data = limit - CCSDS_PRIMARY_HEADER_SIZE;
+    uint32_t min_data = config->crc ? 3 : 1;
+    uint32_t roll = test_range(state, 0, 99);
+    uint32_t high = (roll < 80) ? 256 : (roll < 98) ? 4096 : max_data;
+    return test_range(state, min_data, (high < max_data) ? high : max_data);
+}
+
+// TM Transfer Frame settings of the frame tests
+static const struct ccsds_frame_config test_frame_config = { 1115, 1, 1, 42 };
+#define TEST_FRAME_VCID     3
+
+// wrap a packet stream into frames of test_frame_config on TEST_FRAME_VCID,
+// the packet zone behind the last packet is filled with an idle packet
+static inline void test_frames(struct test_bytes* frames, const struct test_bytes* packets)
+{
+    const struct ccsds_frame_config* config = &test_frame_config;
+    uint32_t zone_size = config->length - CCSDS_FRAME_PRIMARY_HEADER_SIZE - (config->fecf ? CCSDS_FRAME_FECF_SIZE : 0);
+    uint8_t frame[CCSDS_FRAME_ASM_SIZE + CCSDS_FRAME_MAX_SIZE];
+    size_t next_packet = 0;
+    uint8_t vc_count = 0;
+    for (size_t pos = 0; pos < packets->len; pos += zone_size)
+    {
+        uint8_t* out = frame;
+        if (config->asm_sync)
+        {
+            out[0] = CCSDS_FRAME_ASM >> 24;
+            out[1] = (CCSDS_FRAME_ASM >> 16) & 0xFF;
+            out[2] = (CCSDS_FRAME_ASM >> 8) & 0xFF;
+            out[3] = CCSDS_FRAME_ASM & 0xFF;
+            out += CCSDS_FRAME_ASM_SIZE;
+        }
+        while (next_packet < pos)
+        {
+            const uint8_t* p = &packets->data[next_packet];
+            next_packet += CCSDS_PRIMARY_HEADER_SIZE + (p[4] << 8 | p[5]) + 1;
+        }
+        uint16_t fhp = (next_packet < pos + zone_size) ? next_packet - pos : CCSDS_FRAME_FHP_NONE;
+        uint16_t id = config->scid << 4 | TEST_FRAME_VCID << 1;
+        out[0] = id >> 8;
+        out[1] = id & 0xFF;
+        out[2] = vc_count;
+        out[3] = vc_count++;
+        out[4] = fhp >> 8;
+        out[5] = fhp & 0xFF;
+        uint8_t* zone = &out[CCSDS_FRAME_PRIMARY_HEADER_SIZE];
+        uint32_t n = (packets->len - pos < zone_size) ? packets->len - pos : zone_size;
+        memcpy(zone, &packets->data[pos], n);
+        if (n < zone_size)
+        {
+            // idle packet (APID 0x7FE, not configured for the tests) up to the end of the zone,
+            // or zeros if it does not fit
+            memset(&zone[n], 0, zone_size - n);
+            if (zone_size - n > CCSDS_PRIMARY_HEADER_SIZE)
+            {
+                uint32_t data_length = zone_size - n - CCSDS_PRIMARY_HEADER_SIZE;
+                zone[n] = 0x07;
+                zone[n + 1] = 0xFE;
+                zone[n + 2] = 0xC0;
+                zone[n + 4] = (data_length - 1) >> 8;
+                zone[n + 5] = (data_length - 1) & 0xFF;
+            }
+        }
+        if (config->fecf)
+        {
+            uint16_t crc = ccsds_crc16_update(CCSDS_CRC16_INIT, out, config->length - 2);
+            out[config->length - 2] = crc >> 8;
+            out[config->length - 1] = crc & 0xFF;
+        }
+        test_bytes_append(frames, frame, (out - frame) + config->length);
+    }
+}
+
+#endif